@@ -18,10 +18,13 @@
 #pragma once
 
 // My includes
+#include "PriorityQueue.h"
 #include "VoronoiDiagram.h"
 
+template<typename T>
 class Event;
 
+template<typename T>
 struct Arc
 {
 	enum class Color { RED, BLACK };
@@ -31,10 +34,10 @@ struct Arc
 	Arc* left;
 	Arc* right;
 	// Diagram
-	VoronoiDiagram::Site* site;
-	VoronoiDiagram::HalfEdge* leftHalfEdge;
-	VoronoiDiagram::HalfEdge* rightHalfEdge;
-	Event* event;
+	typename BasicVoronoiDiagram<T>::Site* site;
+	typename BasicVoronoiDiagram<T>::Index leftHalfEdge;
+	typename BasicVoronoiDiagram<T>::Index rightHalfEdge;
+	typename PriorityQueue<Event<T>>::Handle event;
 	// Optimizations
 	Arc* prev;
 	Arc* next;
@@ -21,59 +21,106 @@
 #include <cmath>
 // My includes
 #include "Arc.h"
+#include "SimdKernels.h"
 
-Beachline::Beachline() : mNil(new Arc), mRoot(mNil)
+template<typename T>
+Beachline<T>::Beachline() : mCurrentChunk(0), mNbUsedInCurrentChunk(0), mFreeArcs(nullptr), mNil(createNil()), mRoot(mNil)
 {
-    mNil->color = Arc::Color::BLACK; 
+
 }
 
-Beachline::~Beachline()
+template<typename T>
+Beachline<T>::~Beachline() = default;
+
+template<typename T>
+void Beachline<T>::clear()
 {
-    free(mRoot);    
-    delete mNil;
+    // Start again from the beginning of the first chunk
+    mCurrentChunk = 0;
+    mNbUsedInCurrentChunk = 0;
+    mFreeArcs = nullptr;
+    mNil = createNil();
+    mRoot = mNil;
+    FORTUNE_STATISTICS(mNbArcs = 0);
 }
 
-Arc* Beachline::createArc(VoronoiDiagram::Site* site)
+template<typename T>
+void Beachline<T>::reserveHeadroom()
 {
-    return new Arc{mNil, mNil, mNil, site, nullptr, nullptr, nullptr, mNil, mNil, Arc::Color::RED};
+    // The chunks before the current one are full, i chunks hold FIRST_CHUNK_SIZE * (2^i - 1) arcs
+    // The chunks left by allocateArc hold less than twice the arcs used plus one chunk, so they always grow after the
+    // first run, then only if the number of arcs doubles
+    std::size_t nbUsed = (FIRST_CHUNK_SIZE << mCurrentChunk) - FIRST_CHUNK_SIZE + mNbUsedInCurrentChunk;
+    auto getCapacity = [this]() { return (FIRST_CHUNK_SIZE << mChunks.size()) - FIRST_CHUNK_SIZE; };
+    if (getCapacity() >= 2 * nbUsed + FIRST_CHUNK_SIZE)
+        return;
+    while (getCapacity() < 4 * nbUsed + 2 * FIRST_CHUNK_SIZE)
+        mChunks.push_back(std::make_unique<Arc<T>[]>(FIRST_CHUNK_SIZE << mChunks.size()));
+}
+
+template<typename T>
+Arc<T>* Beachline<T>::createArc(typename BasicVoronoiDiagram<T>::Site* site)
+{
+    Arc<T>* x = allocateArc();
+    FORTUNE_STATISTICS(++mNbArcs);
+    *x = Arc<T>{mNil, mNil, mNil, site, BasicVoronoiDiagram<T>::INVALID_INDEX, BasicVoronoiDiagram<T>::INVALID_INDEX, PriorityQueue<Event<T>>::INVALID_HANDLE, mNil, mNil, Arc<T>::Color::RED};
+    return x;
 }
 
-bool Beachline::isEmpty() const
+template<typename T>
+void Beachline<T>::deleteArc(Arc<T>* x)
+{
+    // The arc must have been removed from the tree before
+    FORTUNE_STATISTICS(--mNbArcs);
+    x->next = mFreeArcs;
+    mFreeArcs = x;
+}
+
+template<typename T>
+bool Beachline<T>::isEmpty() const
 {
     return isNil(mRoot);
 }
 
-bool Beachline::isNil(const Arc* x) const
+template<typename T>
+bool Beachline<T>::isNil(const Arc<T>* x) const
 {
     return x == mNil;
 }
 
-void Beachline::setRoot(Arc* x)
+template<typename T>
+void Beachline<T>::setRoot(Arc<T>* x)
 {
     mRoot = x;
-    mRoot->color = Arc::Color::BLACK;
+    mRoot->color = Arc<T>::Color::BLACK;
 }
 
-Arc* Beachline::getLeftmostArc() const
+template<typename T>
+Arc<T>* Beachline<T>::getLeftmostArc() const
 {
-    Arc* x = mRoot;
+    Arc<T>* x = mRoot;
     while (!isNil(x->prev))
         x = x->prev;
     return x;
 }
 
-Arc* Beachline::locateArcAbove(const Vector2& point, double l) const
+template<typename T>
+Arc<T>* Beachline<T>::locateArcAbove(const BasicVector2<T>& point, double l) const
 {
-    Arc* node = mRoot;
+    Arc<T>* node = mRoot;
     bool found = false;
+    FORTUNE_STATISTICS(mLastLocationDepth = 0);
     while (!found)
     {
-        double breakpointLeft = -std::numeric_limits<double>::infinity();
-        double breakpointRight = std::numeric_limits<double>::infinity();
-        if (!isNil(node->prev))
-           breakpointLeft =  computeBreakpoint(node->prev->site->point, node->site->point, l);
-        if (!isNil(node->next))
-            breakpointRight = computeBreakpoint(node->site->point, node->next->site->point, l);
+        FORTUNE_STATISTICS(++mLastLocationDepth);
+        // Both breakpoints are computed together, a missing neighbor is replaced by the arc itself and ignored
+        bool hasPrev = !isNil(node->prev);
+        bool hasNext = !isNil(node->next);
+        const BasicVector2<T>& sitePoint = node->site->point;
+        std::array<double, 2> breakpoints = computeBreakpoints(hasPrev ? node->prev->site->point : sitePoint, sitePoint,
+            hasNext ? node->next->site->point : sitePoint, l);
+        double breakpointLeft = hasPrev ? breakpoints[0] : -std::numeric_limits<double>::infinity();
+        double breakpointRight = hasNext ? breakpoints[1] : std::numeric_limits<double>::infinity();
         if (point.x < breakpointLeft)
             node = node->left;
         else if (point.x > breakpointRight)
@@ -84,7 +131,22 @@ Arc* Beachline::locateArcAbove(const Vector2& point, double l) const
     return node;
 }
 
-void Beachline::insertBefore(Arc* x, Arc* y)
+#if FORTUNE_ENABLE_STATISTICS
+template<typename T>
+std::size_t Beachline<T>::getNbArcs() const
+{
+    return mNbArcs;
+}
+
+template<typename T>
+std::size_t Beachline<T>::getLastLocationDepth() const
+{
+    return mLastLocationDepth;
+}
+#endif
+
+template<typename T>
+void Beachline<T>::insertBefore(Arc<T>* x, Arc<T>* y)
 {
     // Find the right place
     if (isNil(x->left))
@@ -107,7 +169,8 @@ void Beachline::insertBefore(Arc* x, Arc* y)
     insertFixup(y);    
 }
 
-void Beachline::insertAfter(Arc* x, Arc* y)
+template<typename T>
+void Beachline<T>::insertAfter(Arc<T>* x, Arc<T>* y)
 {
     // Find the right place
     if (isNil(x->right))
@@ -130,7 +193,8 @@ void Beachline::insertAfter(Arc* x, Arc* y)
     insertFixup(y);    
 }
 
-void Beachline::replace(Arc* x, Arc* y)
+template<typename T>
+void Beachline<T>::replace(Arc<T>* x, Arc<T>* y)
 {
     transplant(x, y);
     y->left = x->left;
@@ -148,11 +212,12 @@ void Beachline::replace(Arc* x, Arc* y)
     y->color = x->color;
 }
 
-void Beachline::remove(Arc* z)
+template<typename T>
+void Beachline<T>::remove(Arc<T>* z)
 {
-    Arc* y = z;
-    Arc::Color yOriginalColor = y->color;
-    Arc* x;
+    Arc<T>* y = z;
+    typename Arc<T>::Color yOriginalColor = y->color;
+    Arc<T>* x;
     if (isNil(z->left))
     {
         x = z->right;
@@ -181,7 +246,7 @@ void Beachline::remove(Arc* z)
         y->left->parent = y;
         y->color = z->color;
     }
-    if (yOriginalColor == Arc::Color::BLACK)
+    if (yOriginalColor == Arc<T>::Color::BLACK)
         removeFixup(x);
     // Update next and prev
     if (!isNil(z->prev))
@@ -190,10 +255,11 @@ void Beachline::remove(Arc* z)
         z->next->prev = z->prev;
 }
 
-std::ostream& Beachline::print(std::ostream& os) const
+template<typename T>
+std::ostream& Beachline<T>::print(std::ostream& os) const
 {
     //return printArc(os, mRoot);
-    Arc* arc = getLeftmostArc();
+    Arc<T>* arc = getLeftmostArc();
     while (!isNil(arc))
     {
         os << arc->site->index << ' ';
@@ -202,14 +268,16 @@ std::ostream& Beachline::print(std::ostream& os) const
     return os;
 }
 
-Arc* Beachline::minimum(Arc* x) const
+template<typename T>
+Arc<T>* Beachline<T>::minimum(Arc<T>* x) const
 {
     while (!isNil(x->left))
         x = x->left;
     return x;
 }
 
-void Beachline::transplant(Arc* u, Arc* v)
+template<typename T>
+void Beachline<T>::transplant(Arc<T>* u, Arc<T>* v)
 {
     if (isNil(u->parent))
         mRoot = v;
@@ -220,19 +288,20 @@ void Beachline::transplant(Arc* u, Arc* v)
     v->parent = u->parent;
 }
 
-void Beachline::insertFixup(Arc* z)
+template<typename T>
+void Beachline<T>::insertFixup(Arc<T>* z)
 {
-    while (z->parent->color == Arc::Color::RED)
+    while (z->parent->color == Arc<T>::Color::RED)
     {
         if (z->parent == z->parent->parent->left)
         {
-            Arc* y = z->parent->parent->right;
+            Arc<T>* y = z->parent->parent->right;
             // Case 1
-            if (y->color == Arc::Color::RED)
+            if (y->color == Arc<T>::Color::RED)
             {
-                z->parent->color = Arc::Color::BLACK;
-                y->color = Arc::Color::BLACK;
-                z->parent->parent->color = Arc::Color::RED;
+                z->parent->color = Arc<T>::Color::BLACK;
+                y->color = Arc<T>::Color::BLACK;
+                z->parent->parent->color = Arc<T>::Color::RED;
                 z = z->parent->parent;
             }
             else
@@ -244,20 +313,20 @@ void Beachline::insertFixup(Arc* z)
                     leftRotate(z);
                 }
                 // Case 3
-                z->parent->color = Arc::Color::BLACK;
-                z->parent->parent->color = Arc::Color::RED;
+                z->parent->color = Arc<T>::Color::BLACK;
+                z->parent->parent->color = Arc<T>::Color::RED;
                 rightRotate(z->parent->parent);
             }
         }
         else
         {
-            Arc* y = z->parent->parent->left;
+            Arc<T>* y = z->parent->parent->left;
             // Case 1
-            if (y->color == Arc::Color::RED)
+            if (y->color == Arc<T>::Color::RED)
             {
-                z->parent->color = Arc::Color::BLACK;
-                y->color = Arc::Color::BLACK;
-                z->parent->parent->color = Arc::Color::RED;
+                z->parent->color = Arc<T>::Color::BLACK;
+                y->color = Arc<T>::Color::BLACK;
+                z->parent->parent->color = Arc<T>::Color::RED;
                 z = z->parent->parent;
             }
             else
@@ -269,52 +338,53 @@ void Beachline::insertFixup(Arc* z)
                     rightRotate(z);
                 }
                 // Case 3
-                z->parent->color = Arc::Color::BLACK;
-                z->parent->parent->color = Arc::Color::RED;
+                z->parent->color = Arc<T>::Color::BLACK;
+                z->parent->parent->color = Arc<T>::Color::RED;
                 leftRotate(z->parent->parent);
             }
         }
     }
-    mRoot->color = Arc::Color::BLACK;
+    mRoot->color = Arc<T>::Color::BLACK;
 }
 
-void Beachline::removeFixup(Arc* x)
+template<typename T>
+void Beachline<T>::removeFixup(Arc<T>* x)
 {
 
-    while (x != mRoot && x->color == Arc::Color::BLACK)
+    while (x != mRoot && x->color == Arc<T>::Color::BLACK)
     {
-        Arc* w;
+        Arc<T>* w;
         if (x == x->parent->left)
         {
             w = x->parent->right;
             // Case 1
-            if (w->color == Arc::Color::RED)
+            if (w->color == Arc<T>::Color::RED)
             {
-                w->color = Arc::Color::BLACK;
-                x->parent->color = Arc::Color::RED;
+                w->color = Arc<T>::Color::BLACK;
+                x->parent->color = Arc<T>::Color::RED;
                 leftRotate(x->parent);
                 w = x->parent->right;
             }
             // Case 2
-            if (w->left->color == Arc::Color::BLACK && w->right->color == Arc::Color::BLACK)
+            if (w->left->color == Arc<T>::Color::BLACK && w->right->color == Arc<T>::Color::BLACK)
             {
-                w->color = Arc::Color::RED;
+                w->color = Arc<T>::Color::RED;
                 x = x->parent;
             }
             else
             {
                 // Case 3
-                if (w->right->color == Arc::Color::BLACK)
+                if (w->right->color == Arc<T>::Color::BLACK)
                 {
-                    w->left->color = Arc::Color::BLACK;
-                    w->color = Arc::Color::RED;
+                    w->left->color = Arc<T>::Color::BLACK;
+                    w->color = Arc<T>::Color::RED;
                     rightRotate(w);
                     w = x->parent->right;
                 }
                 // Case 4
                 w->color = x->parent->color;
-                x->parent->color = Arc::Color::BLACK;
-                w->right->color = Arc::Color::BLACK;
+                x->parent->color = Arc<T>::Color::BLACK;
+                w->right->color = Arc<T>::Color::BLACK;
                 leftRotate(x->parent);
                 x = mRoot;
             }
@@ -323,44 +393,45 @@ void Beachline::removeFixup(Arc* x)
         {
             w = x->parent->left;
             // Case 1
-            if (w->color == Arc::Color::RED)
+            if (w->color == Arc<T>::Color::RED)
             {
-                w->color = Arc::Color::BLACK;
-                x->parent->color = Arc::Color::RED;
+                w->color = Arc<T>::Color::BLACK;
+                x->parent->color = Arc<T>::Color::RED;
                 rightRotate(x->parent);
                 w = x->parent->left;
             }
             // Case 2
-            if (w->left->color == Arc::Color::BLACK && w->right->color == Arc::Color::BLACK)
+            if (w->left->color == Arc<T>::Color::BLACK && w->right->color == Arc<T>::Color::BLACK)
             {
-                w->color = Arc::Color::RED;
+                w->color = Arc<T>::Color::RED;
                 x = x->parent;
             }
             else
             {
                 // Case 3
-                if (w->left->color == Arc::Color::BLACK)
+                if (w->left->color == Arc<T>::Color::BLACK)
                 {
-                    w->right->color = Arc::Color::BLACK;
-                    w->color = Arc::Color::RED;
+                    w->right->color = Arc<T>::Color::BLACK;
+                    w->color = Arc<T>::Color::RED;
                     leftRotate(w);
                     w = x->parent->left;
                 }
                 // Case 4
                 w->color = x->parent->color;
-                x->parent->color = Arc::Color::BLACK;
-                w->left->color = Arc::Color::BLACK;
+                x->parent->color = Arc<T>::Color::BLACK;
+                w->left->color = Arc<T>::Color::BLACK;
                 rightRotate(x->parent);
                 x = mRoot;
             } 
         }
     }
-    x->color = Arc::Color::BLACK;
+    x->color = Arc<T>::Color::BLACK;
 }
 
-void Beachline::leftRotate(Arc* x)
+template<typename T>
+void Beachline<T>::leftRotate(Arc<T>* x)
 {
-    Arc* y = x->right;
+    Arc<T>* y = x->right;
     x->right = y->left;
     if (!isNil(y->left))
         y->left->parent = x;
@@ -375,9 +446,10 @@ void Beachline::leftRotate(Arc* x)
     x->parent = y;
 }
 
-void Beachline::rightRotate(Arc* y)
+template<typename T>
+void Beachline<T>::rightRotate(Arc<T>* y)
 {
-    Arc* x = y->left;
+    Arc<T>* x = y->left;
     y->left = x->right;
     if (!isNil(x->right))
         x->right->parent = y;
@@ -392,31 +464,40 @@ void Beachline::rightRotate(Arc* y)
     y->parent = x;
 }
 
-double Beachline::computeBreakpoint(const Vector2& point1, const Vector2& point2, double l) const
+template<typename T>
+Arc<T>* Beachline<T>::allocateArc()
 {
-    double x1 = point1.x, y1 = point1.y, x2 = point2.x, y2 = point2.y;
-    double d1 = 1.0 / (2.0 * (y1 - l));
-	double d2 = 1.0 / (2.0 * (y2 - l));
-	double a = d1 - d2;
-	double b = 2.0 * (x2 * d2 - x1 * d1);
-	double c = (y1 * y1 + x1 * x1 - l * l) * d1 - (y2 * y2 + x2 * x2 - l * l) * d2;
-	double delta = b * b - 4.0 * a * c;
-    return (-b + std::sqrt(delta)) / (2.0 * a);
+    // Recycle a deleted arc if possible
+    if (mFreeArcs != nullptr)
+    {
+        Arc<T>* x = mFreeArcs;
+        mFreeArcs = x->next;
+        return x;
+    }
+    // Otherwise take the next free slot of the current chunk, the chunk i contains FIRST_CHUNK_SIZE * 2^i arcs
+    if (mChunks.empty())
+        mChunks.push_back(std::make_unique<Arc<T>[]>(FIRST_CHUNK_SIZE));
+    else if (mNbUsedInCurrentChunk == FIRST_CHUNK_SIZE << mCurrentChunk)
+    {
+        // Move to the next chunk, add a twice bigger one if there is none
+        ++mCurrentChunk;
+        mNbUsedInCurrentChunk = 0;
+        if (mCurrentChunk == mChunks.size())
+            mChunks.push_back(std::make_unique<Arc<T>[]>(FIRST_CHUNK_SIZE << mCurrentChunk));
+    }
+    return &mChunks[mCurrentChunk][mNbUsedInCurrentChunk++];
 }
 
-void Beachline::free(Arc* x)
+template<typename T>
+Arc<T>* Beachline<T>::createNil()
 {
-    if (isNil(x))
-        return;
-    else
-    {
-        free(x->left);
-        free(x->right);
-        delete x;
-    }
+    Arc<T>* nil = allocateArc();
+    *nil = Arc<T>{nil, nil, nil, nullptr, BasicVoronoiDiagram<T>::INVALID_INDEX, BasicVoronoiDiagram<T>::INVALID_INDEX, PriorityQueue<Event<T>>::INVALID_HANDLE, nil, nil, Arc<T>::Color::BLACK};
+    return nil;
 }
 
-std::ostream& Beachline::printArc(std::ostream& os, const Arc* arc, std::string tabs) const
+template<typename T>
+std::ostream& Beachline<T>::printArc(std::ostream& os, const Arc<T>* arc, std::string tabs) const
 {
     os << tabs << arc->site->index << ' ' << arc->leftHalfEdge << ' ' << arc->rightHalfEdge << std::endl;
     if (!isNil(arc->left))
@@ -426,7 +507,15 @@ std::ostream& Beachline::printArc(std::ostream& os, const Arc* arc, std::string
     return os;
 }
 
-std::ostream& operator<<(std::ostream& os, const Beachline& beachline)
+template<typename T>
+std::ostream& operator<<(std::ostream& os, const Beachline<T>& beachline)
 {
     return beachline.print(os);
 }
+
+// Explicit instantiations
+
+template class Beachline<float>;
+template class Beachline<double>;
+template std::ostream& operator<<(std::ostream& os, const Beachline<float>& beachline);
+template std::ostream& operator<<(std::ostream& os, const Beachline<double>& beachline);
@@ -17,12 +17,18 @@
 
 #pragma once
 
+// STL
+#include <memory>
+#include <vector>
 // My includes
+#include "FortuneStatistics.h"
 #include "Vector2.h"
 #include "VoronoiDiagram.h"
 
+template<typename T>
 struct Arc;
 
+template<typename T>
 class Beachline
 {
 public:
@@ -35,42 +41,67 @@ public:
     Beachline(Beachline&&) = delete;
     Beachline& operator=(Beachline&&) = delete;
 
-    Arc* createArc(VoronoiDiagram::Site* site);
-    
+    // Remove all the arcs, the arena keeps its chunks
+    void clear();
+    // Add chunks for four times as many arcs as the most used, if needed, as reserveHeadroom in Reserve.h
+    void reserveHeadroom();
+
+    Arc<T>* createArc(typename BasicVoronoiDiagram<T>::Site* site);
+    void deleteArc(Arc<T>* x);
+
     bool isEmpty() const;
-    bool isNil(const Arc* x) const;
-    void setRoot(Arc* x);
-    Arc* getLeftmostArc() const;
+    bool isNil(const Arc<T>* x) const;
+    void setRoot(Arc<T>* x);
+    Arc<T>* getLeftmostArc() const;
 
-    Arc* locateArcAbove(const Vector2& point, double l) const;
-    void insertBefore(Arc* x, Arc* y);
-    void insertAfter(Arc* x, Arc* y);
-    void replace(Arc* x, Arc* y);
-    void remove(Arc* z);
+    Arc<T>* locateArcAbove(const BasicVector2<T>& point, double l) const;
+    void insertBefore(Arc<T>* x, Arc<T>* y);
+    void insertAfter(Arc<T>* x, Arc<T>* y);
+    void replace(Arc<T>* x, Arc<T>* y);
+    void remove(Arc<T>* z);
 
     std::ostream& print(std::ostream& os) const;
 
+#if FORTUNE_ENABLE_STATISTICS
+    std::size_t getNbArcs() const;
+    std::size_t getLastLocationDepth() const; // Nodes visited by the last call to locateArcAbove
+#endif
+
 private:
-    Arc* mNil;
-    Arc* mRoot;
+    // Arena: arcs are carved out of chunks of geometrically growing size and
+    // recycled through an intrusive free list, chunks are only released with the beachline
+    static constexpr std::size_t FIRST_CHUNK_SIZE = 64;
+    std::vector<std::unique_ptr<Arc<T>[]>> mChunks;
+    std::size_t mCurrentChunk;
+    std::size_t mNbUsedInCurrentChunk;
+    Arc<T>* mFreeArcs;
+
+    Arc<T>* mNil;
+    Arc<T>* mRoot;
+
+#if FORTUNE_ENABLE_STATISTICS
+    std::size_t mNbArcs = 0;
+    mutable std::size_t mLastLocationDepth = 0;
+#endif
+
+    // Memory management
+    Arc<T>* allocateArc();
+    Arc<T>* createNil();
 
     // Utility methods
-    Arc* minimum(Arc* x) const;
-    void transplant(Arc* u, Arc* v); 
+    Arc<T>* minimum(Arc<T>* x) const;
+    void transplant(Arc<T>* u, Arc<T>* v); 
 
     // Fixup functions
-    void insertFixup(Arc* z);
-    void removeFixup(Arc* x);
+    void insertFixup(Arc<T>* z);
+    void removeFixup(Arc<T>* x);
 
     // Rotations
-    void leftRotate(Arc* x);
-    void rightRotate(Arc* y);
-
-    double computeBreakpoint(const Vector2& point1, const Vector2& point2, double l) const;
-
-    void free(Arc* x);
+    void leftRotate(Arc<T>* x);
+    void rightRotate(Arc<T>* y);
 
-    std::ostream& printArc(std::ostream& os, const Arc* arc, std::string tabs = "") const;
+    std::ostream& printArc(std::ostream& os, const Arc<T>* arc, std::string tabs = "") const;
 };
 
-std::ostream& operator<<(std::ostream& os, const Beachline& beachline);
+template<typename T>
+std::ostream& operator<<(std::ostream& os, const Beachline<T>& beachline);
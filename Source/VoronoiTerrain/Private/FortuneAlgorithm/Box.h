@@ -20,10 +20,12 @@
 // STL
 #include <array>
 #include <limits>
+#include <utility>
 // My includes
 #include "Vector2.h"
 
-class Box
+template<typename T>
+class BasicBox
 {
 public:
     // Be careful, y-axis is oriented to the top like in math
@@ -32,19 +34,151 @@ public:
     struct Intersection
     {
         Side side;
-        Vector2 point;
+        BasicVector2<T> point;
     };
 
-    double left;
-    double bottom;
-    double right;
-    double top;
+    T left;
+    T bottom;
+    T right;
+    T top;
 
-    bool contains(const Vector2& point) const;
-    Intersection getFirstIntersection(const Vector2& origin, const Vector2& direction) const; // Useful for Fortune's algorithm
-    int getIntersections(const Vector2& origin, const Vector2& destination, std::array<Intersection, 2>& intersections) const; // Useful for diagram intersection
+    constexpr bool contains(const BasicVector2<T>& point) const
+    {
+        return point.x >= left - EPSILON && point.x <= right + EPSILON &&
+            point.y >= bottom  - EPSILON && point.y <= top + EPSILON;
+    }
+
+    // Useful for Fortune's algorithm
+    constexpr Intersection getFirstIntersection(const BasicVector2<T>& origin, const BasicVector2<T>& direction) const
+    {
+        // origin must be in the box
+        Intersection intersection = Intersection();
+        T t = std::numeric_limits<T>::infinity();
+        if (direction.x > T(0))
+        {
+            t = (right - origin.x) / direction.x;
+            intersection.side = Side::RIGHT;
+            intersection.point = origin + t * direction;
+        }
+        else if (direction.x < T(0))
+        {
+            t = (left - origin.x) / direction.x;
+            intersection.side = Side::LEFT;
+            intersection.point = origin + t * direction;
+        }
+        if (direction.y > T(0))
+        {
+            T newT = (top - origin.y) / direction.y;
+            if (newT < t)
+            {
+                intersection.side = Side::TOP;
+                intersection.point = origin + newT * direction;
+            }
+        }
+        else if (direction.y < T(0))
+        {
+            T newT = (bottom - origin.y) / direction.y;
+            if (newT < t)
+            {
+                intersection.side = Side::BOTTOM;
+                intersection.point = origin + newT * direction;
+            }
+        }
+        return intersection;
+    }
+
+    // Useful for diagram intersection, the points are computed on the line if its direction is not null
+    constexpr int getIntersections(const BasicVector2<T>& origin, const BasicVector2<T>& destination,
+        const BasicVector2<double>& linePoint, const BasicVector2<double>& lineDirection,
+        std::array<Intersection, 2>& intersections) const
+    {
+        // WARNING: If the intersection is a corner, both intersections are equals
+        // The points are computed in double, in float the vertices far from the box make them too inaccurate
+        BasicVector2<double> start(origin);
+        BasicVector2<double> end(destination);
+        std::array<BasicVector2<double>, 2> points;
+        std::size_t i = 0; // index of the current intersection
+        // Left
+        if (origin.x < left - EPSILON || destination.x < left - EPSILON)
+        {
+            if (getCrossing(start, end, linePoint, lineDirection, &BasicVector2<double>::x, left, points[i]))
+            {
+                intersections[i].side = Side::LEFT;
+                intersections[i].point = BasicVector2<T>(points[i]);
+                if (points[i].y >= bottom  - EPSILON && points[i].y <= top + EPSILON)
+                    ++i;
+            }
+        }
+        // Right
+        if (origin.x > right + EPSILON || destination.x > right + EPSILON)
+        {
+            if (getCrossing(start, end, linePoint, lineDirection, &BasicVector2<double>::x, right, points[i]))
+            {
+                intersections[i].side = Side::RIGHT;
+                intersections[i].point = BasicVector2<T>(points[i]);
+                if (points[i].y >= bottom - EPSILON && points[i].y <= top + EPSILON)
+                    ++i;
+            }
+        }
+        // Bottom
+        if (i < 2 && (origin.y < bottom - EPSILON || destination.y < bottom - EPSILON))
+        {
+            if (getCrossing(start, end, linePoint, lineDirection, &BasicVector2<double>::y, bottom, points[i]))
+            {
+                intersections[i].side = Side::BOTTOM;
+                intersections[i].point = BasicVector2<T>(points[i]);
+                if (points[i].x >= left  - EPSILON && points[i].x <= right + EPSILON)
+                    ++i;
+            }
+        }
+        // Top
+        if (i < 2 && (origin.y > top + EPSILON || destination.y > top + EPSILON))
+        {
+            if (getCrossing(start, end, linePoint, lineDirection, &BasicVector2<double>::y, top, points[i]))
+            {
+                intersections[i].side = Side::TOP;
+                intersections[i].point = BasicVector2<T>(points[i]);
+                if (points[i].x >= left - EPSILON && points[i].x <= right + EPSILON)
+                    ++i;
+            }
+        }
+        // Sort the intersections from the nearest to the farthest, with the points because the parameters along the
+        // segment can be rounded to the same value if its ends are very far away
+        if (i == 2 && (points[1] - points[0]).dot(end - start) < 0.0)
+            std::swap(intersections[0], intersections[1]);
+        return static_cast<int>(i);
+    }
 
 private:
-    static constexpr double EPSILON = std::numeric_limits<double>::epsilon();
+    static constexpr T EPSILON = std::numeric_limits<T>::epsilon();
+
+    // Crossing of the segment with the line where coordinate is value, if the ends are strictly on both sides of it
+    // The ends can be vertices of nearly aligned sites, very far away and inaccurate: the point is computed on the line
+    // if it is on the segment, otherwise from the nearest end
+    static constexpr bool getCrossing(const BasicVector2<double>& start, const BasicVector2<double>& end,
+        const BasicVector2<double>& linePoint, const BasicVector2<double>& lineDirection,
+        double BasicVector2<double>::* coordinate, double value, BasicVector2<double>& point)
+    {
+        double startDistance = value - start.*coordinate;
+        double endDistance = end.*coordinate - value;
+        bool isCrossing = (startDistance > EPSILON && endDistance > EPSILON) ||
+            (startDistance < -EPSILON && endDistance < -EPSILON);
+        if (!isCrossing)
+            return false;
+        if (lineDirection.*coordinate != 0.0)
+        {
+            point = linePoint + ((value - linePoint.*coordinate) / lineDirection.*coordinate) * lineDirection;
+            if ((point - start).dot(end - point) >= 0.0)
+                return true;
+        }
+        BasicVector2<double> direction = end - start;
+        if (startDistance * startDistance <= endDistance * endDistance)
+            point = start + (startDistance / direction.*coordinate) * direction;
+        else
+            point = end - (endDistance / direction.*coordinate) * direction;
+        return true;
+    }
 };
 
+using Box = BasicBox<double>;
+using Boxf = BasicBox<float>;
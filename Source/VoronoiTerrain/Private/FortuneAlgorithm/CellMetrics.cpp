@@ -0,0 +1,184 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CellMetrics.h"
+// STL
+#include <algorithm>
+#include <limits>
+// My includes
+#include "Parallel.h"
+#include "SimdKernels.h"
+
+namespace
+{
+    // The edges of a cell are processed by pairs, the last one or two edges, which close the cell, go in lane 0
+    // The scalar version keeps two lanes too so that the sums are done in the same order
+    void computeMetrics(const Vector2* points, std::size_t nbPoints, CellMetrics& metrics, std::size_t i)
+    {
+        constexpr double INFINITY_VALUE = std::numeric_limits<double>::infinity();
+        // Relatively to the first corner to keep the precision on cells far from the origin
+        const Vector2 origin = points[0];
+        double areas[2] = {0.0, 0.0};
+        double centroidXs[2] = {0.0, 0.0};
+        double centroidYs[2] = {0.0, 0.0};
+        double perimeters[2] = {0.0, 0.0};
+        double minXs[2] = {INFINITY_VALUE, INFINITY_VALUE};
+        double minYs[2] = {INFINITY_VALUE, INFINITY_VALUE};
+        double maxXs[2] = {-INFINITY_VALUE, -INFINITY_VALUE};
+        double maxYs[2] = {-INFINITY_VALUE, -INFINITY_VALUE};
+        std::size_t j = 0;
+#if FORTUNE_USE_SSE2
+        __m128d originX = _mm_set1_pd(origin.x);
+        __m128d originY = _mm_set1_pd(origin.y);
+        __m128d area = _mm_setzero_pd();
+        __m128d centroidX = _mm_setzero_pd();
+        __m128d centroidY = _mm_setzero_pd();
+        __m128d perimeter = _mm_setzero_pd();
+        __m128d minX = _mm_set1_pd(INFINITY_VALUE);
+        __m128d minY = _mm_set1_pd(INFINITY_VALUE);
+        __m128d maxX = _mm_set1_pd(-INFINITY_VALUE);
+        __m128d maxY = _mm_set1_pd(-INFINITY_VALUE);
+        for (; j + 2 < nbPoints; j += 2)
+        {
+            // Lane k is the edge from corner j + k to corner j + k + 1
+            __m128d a = _mm_loadu_pd(&points[j].x);
+            __m128d b = _mm_loadu_pd(&points[j + 1].x);
+            __m128d c = _mm_loadu_pd(&points[j + 2].x);
+            __m128d px = _mm_sub_pd(_mm_unpacklo_pd(a, b), originX);
+            __m128d py = _mm_sub_pd(_mm_unpackhi_pd(a, b), originY);
+            __m128d qx = _mm_sub_pd(_mm_unpacklo_pd(b, c), originX);
+            __m128d qy = _mm_sub_pd(_mm_unpackhi_pd(b, c), originY);
+            __m128d det = _mm_sub_pd(_mm_mul_pd(px, qy), _mm_mul_pd(qx, py));
+            area = _mm_add_pd(area, det);
+            centroidX = _mm_add_pd(centroidX, _mm_mul_pd(_mm_add_pd(px, qx), det));
+            centroidY = _mm_add_pd(centroidY, _mm_mul_pd(_mm_add_pd(py, qy), det));
+            __m128d ex = _mm_sub_pd(qx, px);
+            __m128d ey = _mm_sub_pd(qy, py);
+            perimeter = _mm_add_pd(perimeter, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(ex, ex), _mm_mul_pd(ey, ey))));
+            minX = _mm_min_pd(minX, px);
+            minY = _mm_min_pd(minY, py);
+            maxX = _mm_max_pd(maxX, px);
+            maxY = _mm_max_pd(maxY, py);
+        }
+        _mm_storeu_pd(areas, area);
+        _mm_storeu_pd(centroidXs, centroidX);
+        _mm_storeu_pd(centroidYs, centroidY);
+        _mm_storeu_pd(perimeters, perimeter);
+        _mm_storeu_pd(minXs, minX);
+        _mm_storeu_pd(minYs, minY);
+        _mm_storeu_pd(maxXs, maxX);
+        _mm_storeu_pd(maxYs, maxY);
+#endif
+        std::size_t nbPairedEdges = 2 * ((nbPoints - 1) / 2);
+        for (; j < nbPoints; ++j)
+        {
+            // Lane 0 or 1 for the pairs, lane 0 for the closing edges
+            std::size_t lane = j < nbPairedEdges ? j % 2 : 0;
+            Vector2 p = points[j] - origin;
+            Vector2 q = points[j + 1 < nbPoints ? j + 1 : 0] - origin;
+            double det = p.x * q.y - q.x * p.y;
+            areas[lane] += det;
+            centroidXs[lane] += (p.x + q.x) * det;
+            centroidYs[lane] += (p.y + q.y) * det;
+            double ex = q.x - p.x;
+            double ey = q.y - p.y;
+            perimeters[lane] += std::sqrt(ex * ex + ey * ey);
+            minXs[lane] = std::min(minXs[lane], p.x);
+            minYs[lane] = std::min(minYs[lane], p.y);
+            maxXs[lane] = std::max(maxXs[lane], p.x);
+            maxYs[lane] = std::max(maxYs[lane], p.y);
+        }
+        double doubleArea = areas[0] + areas[1];
+        Vector2 centroid = origin + (1.0 / (3.0 * doubleArea)) * Vector2(centroidXs[0] + centroidXs[1], centroidYs[0] + centroidYs[1]);
+        metrics.areas[i] = 0.5 * doubleArea;
+        metrics.centroids[i] = centroid;
+        metrics.perimeters[i] = perimeters[0] + perimeters[1];
+        metrics.bounds[i] = Box{origin.x + std::min(minXs[0], minXs[1]), origin.y + std::min(minYs[0], minYs[1]),
+            origin.x + std::max(maxXs[0], maxXs[1]), origin.y + std::max(maxYs[0], maxYs[1])};
+        // The cells are convex and contain their centroid, the closest edge is the closest line through an edge
+        // Degenerate edges give NaN and are ignored by min
+        double radius = INFINITY_VALUE;
+        j = 0;
+#if FORTUNE_USE_SSE2
+        __m128d cx = _mm_set1_pd(centroid.x);
+        __m128d cy = _mm_set1_pd(centroid.y);
+        __m128d minDistance = _mm_set1_pd(INFINITY_VALUE);
+        for (; j + 2 < nbPoints; j += 2)
+        {
+            __m128d a = _mm_loadu_pd(&points[j].x);
+            __m128d b = _mm_loadu_pd(&points[j + 1].x);
+            __m128d c = _mm_loadu_pd(&points[j + 2].x);
+            __m128d px = _mm_unpacklo_pd(a, b);
+            __m128d py = _mm_unpackhi_pd(a, b);
+            __m128d ex = _mm_sub_pd(_mm_unpacklo_pd(b, c), px);
+            __m128d ey = _mm_sub_pd(_mm_unpackhi_pd(b, c), py);
+            __m128d det = _mm_sub_pd(_mm_mul_pd(ex, _mm_sub_pd(cy, py)), _mm_mul_pd(ey, _mm_sub_pd(cx, px)));
+            __m128d distance = _mm_div_pd(det, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(ex, ex), _mm_mul_pd(ey, ey))));
+            minDistance = _mm_min_pd(distance, minDistance);
+        }
+        double minDistances[2];
+        _mm_storeu_pd(minDistances, minDistance);
+        radius = std::min(minDistances[0], minDistances[1]);
+#endif
+        for (; j < nbPoints; ++j)
+        {
+            const Vector2& p = points[j];
+            Vector2 edge = points[j + 1 < nbPoints ? j + 1 : 0] - p;
+            double distance = edge.getDet(centroid - p) / edge.getNorm();
+            radius = std::min(radius, distance);
+        }
+        metrics.radii[i] = std::max(radius, 0.0);
+    }
+}
+
+void CellMetrics::resize(std::size_t nbCells)
+{
+    areas.resize(nbCells);
+    centroids.resize(nbCells);
+    perimeters.resize(nbCells);
+    bounds.resize(nbCells);
+    radii.resize(nbCells);
+}
+
+void computeCellMetrics(const VoronoiDiagram::Cells& cells, std::size_t begin, std::size_t end, CellMetrics& metrics)
+{
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        std::size_t first = cells.offsets[i];
+        std::size_t nbPoints = cells.offsets[i + 1] - first;
+        if (nbPoints < 3)
+        {
+            metrics.areas[i] = 0.0;
+            metrics.centroids[i] = Vector2();
+            metrics.perimeters[i] = 0.0;
+            metrics.bounds[i] = Box{0.0, 0.0, 0.0, 0.0};
+            metrics.radii[i] = 0.0;
+            continue;
+        }
+        computeMetrics(&cells.points[first], nbPoints, metrics, i);
+    }
+}
+
+void computeCellMetrics(const VoronoiDiagram::Cells& cells, CellMetrics& metrics, std::size_t nbThreads)
+{
+    std::size_t nbCells = cells.offsets.empty() ? 0 : cells.offsets.size() - 1;
+    metrics.resize(nbCells);
+    parallelFor(std::max<std::size_t>(nbThreads, 1), nbCells, [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        computeCellMetrics(cells, begin, end, metrics);
+    });
+}
@@ -0,0 +1,42 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// STL
+#include <vector>
+// My includes
+#include "VoronoiDiagram.h"
+
+// Measures of the cells exported by VoronoiDiagram::exportCells, one entry per site in each array.
+// An empty cell has a null area, perimeter and radius, and its centroid is the origin.
+struct CellMetrics
+{
+    std::vector<double> areas;
+    std::vector<Vector2> centroids;
+    std::vector<double> perimeters;
+    std::vector<Box> bounds;
+    std::vector<double> radii; // Distance from the centroid to the closest edge
+
+    void resize(std::size_t nbCells);
+};
+
+// Metrics of the cells in [begin, end), metrics must be resized to the number of cells before,
+// disjoint ranges can be computed concurrently
+void computeCellMetrics(const VoronoiDiagram::Cells& cells, std::size_t begin, std::size_t end, CellMetrics& metrics);
+// Metrics of all the cells, split in contiguous ranges over nbThreads
+void computeCellMetrics(const VoronoiDiagram::Cells& cells, CellMetrics& metrics, std::size_t nbThreads = 1);
@@ -17,33 +17,32 @@
 
 #pragma once
 
+// STL
+#include <ostream>
 // My includes
 #include "Vector2.h"
-#include "VoronoiDiagram.h"
 
+template<typename T>
 struct Arc;
 
+// Circle event, the site events are read directly from the sorted sites
+template<typename T>
 class Event
 {
 public:
-    enum class Type{SITE, CIRCLE};
+    Event(double y, BasicVector2<T> point, Arc<T>* arc) : y(y), point(point), arc(arc)
+    {
 
-    // Site event
-    Event(VoronoiDiagram::Site* site);
-    // Circle event
-    Event(double y, Vector2 point, Arc* arc);
-
-    const Type type;
-    double y;
-    int index;
-    // Site event
-    VoronoiDiagram::Site* site;
-    // Circle event
-    Vector2 point;
-    Arc* arc;
+    }
 
+    double y; // Whatever the scalar type, see SimdKernels.h
+    BasicVector2<T> point;
+    Arc<T>* arc;
 };
 
-bool operator<(const Event& lhs, const Event& rhs);
-std::ostream& operator<<(std::ostream& os, const Event& event);
-
+template<typename T>
+std::ostream& operator<<(std::ostream& os, const Event<T>& event)
+{
+    os << "C(" << event.arc << ", " << event.y << ", " << event.point << ")";
+    return os;
+}
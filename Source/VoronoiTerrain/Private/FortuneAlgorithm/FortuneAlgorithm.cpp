@@ -16,43 +16,565 @@
  */
 
 #include "FortuneAlgorithm.h"
+// STL
+#include <algorithm>
+#include <cmath>
+#include <numeric>
 // My includes
 #include "Arc.h"
 #include "Event.h"
+#include "Parallel.h"
+#include "Reserve.h"
+#include "SimdKernels.h"
 
-FortuneAlgorithm::FortuneAlgorithm(std::vector<Vector2> points) : mDiagram(std::move(points)), mBeachlineY(0)
+namespace
 {
+    constexpr std::size_t MIN_SITES_PER_STRIP = 1 << 12;
+    constexpr std::size_t BLOCK_SIZE = 64;
+    constexpr double HALO_WIDTH = 4.0; // In mean distance between the sites
+}
+
+template<typename T>
+BasicFortuneAlgorithm<T>::BasicFortuneAlgorithm() : mBeachlineY(0), mIsTriangulationEnabled(false)
+{
+
+}
+
+template<typename T>
+BasicFortuneAlgorithm<T>::BasicFortuneAlgorithm(std::vector<Vector2> points) :
+    mDiagram(std::move(points)), mBeachlineY(0), mIsTriangulationEnabled(false)
+{
+
+}
 
+template<typename T>
+BasicFortuneAlgorithm<T>::~BasicFortuneAlgorithm() = default;
+
+template<typename T>
+void BasicFortuneAlgorithm<T>::reset(std::span<const Vector2> points)
+{
+    mDiagram.reset(points);
+    mBeachline.clear();
+    mEvents.clear();
+    mBeachlineY = 0;
+    mTriangles.clear();
+    mTriangleNeighbors.clear();
+    mUnboundedEdges.clear();
+    mTopEdges.clear();
+    // An unbounded edge joins two consecutive sites of the hull, the hull can change a lot between two runs
+    mUnboundedEdges.reserve(points.size());
 }
 
-FortuneAlgorithm::~FortuneAlgorithm() = default;
+template<typename T>
+void BasicFortuneAlgorithm<T>::construct()
+{
+    FORTUNE_STATISTICS(auto start = FortuneStatistics::Clock::now());
+    // Sort the sites once by decreasing y
+    std::size_t nbSites = mDiagram.getNbSites();
+    mSortKeys.resize(nbSites);
+    for (std::size_t i = 0; i < nbSites; ++i)
+        mSortKeys[i] = SortKey{getDecreasingKey(mDiagram.getSite(i)->point.y), static_cast<std::uint32_t>(i)};
+    sortKeys(mSortKeys, mSortBuffer, mSortCounts);
+    mSiteOrder.resize(nbSites);
+    for (std::size_t i = 0; i < nbSites; ++i)
+        mSiteOrder[i] = mSortKeys[i].index;
+    sortTiesByX();
+
+    sweep();
+    FORTUNE_STATISTICS(mDiagram.mStatistics.constructTime += FortuneStatistics::getElapsedTime(start));
+}
 
-void FortuneAlgorithm::construct()
+template<typename T>
+void BasicFortuneAlgorithm<T>::constructFromSorted()
 {
-    // Initialize event queue
-    for (std::size_t i = 0; i < mDiagram.getNbSites(); ++i)
-        mEvents.push(std::make_unique<Event>(mDiagram.getSite(i)));
+    FORTUNE_STATISTICS(auto start = FortuneStatistics::Clock::now());
+    mSiteOrder.resize(mDiagram.getNbSites());
+    std::iota(mSiteOrder.begin(), mSiteOrder.end(), 0);
+    sortTiesByX();
+
+    sweep();
+    FORTUNE_STATISTICS(mDiagram.mStatistics.constructTime += FortuneStatistics::getElapsedTime(start));
+}
 
-    // Process events
-    while (!mEvents.isEmpty())
+template<typename T>
+void BasicFortuneAlgorithm<T>::constructParallel(std::size_t nbThreads)
+{
+    std::size_t nbSites = mDiagram.getNbSites();
+    std::size_t nbStrips = std::min(nbThreads, nbSites / MIN_SITES_PER_STRIP);
+    if (nbStrips < 2)
+    {
+        construct();
+        return;
+    }
+    // The fallbacks to construct() measure themselves
+    FORTUNE_STATISTICS(auto start = FortuneStatistics::Clock::now());
+    // Sort the sites by increasing x
+    mSortKeys.resize(nbSites);
+    for (std::size_t i = 0; i < nbSites; ++i)
+        mSortKeys[i] = SortKey{getDecreasingKey(-mDiagram.getSite(i)->point.x), static_cast<std::uint32_t>(i)};
+    sortKeys(mSortKeys, mSortBuffer, mSortCounts);
+    mSiteOrder.resize(nbSites);
+    for (std::size_t i = 0; i < nbSites; ++i)
+        mSiteOrder[i] = mSortKeys[i].index;
+    // Sites with the same x are sorted by y for the hull
+    auto getPoint = [this](Index site) { return mDiagram.getSite(site)->point; };
+    for (std::size_t begin = 0, end = 1; end <= nbSites; ++end)
+    {
+        if (end == nbSites || getPoint(mSiteOrder[end]).x != getPoint(mSiteOrder[begin]).x)
+        {
+            if (end - begin > 1)
+                std::sort(mSiteOrder.begin() + begin, mSiteOrder.begin() + end, [&](Index lhs, Index rhs)
+                {
+                    return getPoint(lhs).y < getPoint(rhs).y;
+                });
+            begin = end;
+        }
+    }
+    mSortedPoints.resize(nbSites);
+    for (std::size_t i = 0; i < nbSites; ++i)
+        mSortedPoints[i] = getPoint(mSiteOrder[i]);
+    // The sites on the hull are shared by all the strips, as the triangles along the hull can be arbitrarily long
+    computeHull();
+    // Range of y of blocks of consecutive sites, to quickly discard the sites far from a circle
+    mBlockYRanges.resize((nbSites + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    for (std::size_t block = 0; block < mBlockYRanges.size(); ++block)
     {
-        std::unique_ptr<Event> event = mEvents.pop();
-        mBeachlineY = event->y;
-        if(event->type == Event::Type::SITE)
-            handleSiteEvent(event.get());
+        std::array<T, 2>& range = mBlockYRanges[block];
+        range = {mSortedPoints[block * BLOCK_SIZE].y, mSortedPoints[block * BLOCK_SIZE].y};
+        for (std::size_t i = block * BLOCK_SIZE; i < std::min((block + 1) * BLOCK_SIZE, nbSites); ++i)
+        {
+            range[0] = std::min(range[0], mSortedPoints[i].y);
+            range[1] = std::max(range[1], mSortedPoints[i].y);
+        }
+    }
+    // The halo is widened for the strips where it is not enough
+    T minY = mBlockYRanges[0][0];
+    T maxY = mBlockYRanges[0][1];
+    for (const std::array<T, 2>& range : mBlockYRanges)
+    {
+        minY = std::min(minY, range[0]);
+        maxY = std::max(maxY, range[1]);
+    }
+    T area = (mSortedPoints.back().x - mSortedPoints.front().x) * (maxY - minY);
+    T haloWidth = T(HALO_WIDTH) * std::sqrt(area / static_cast<T>(nbSites));
+    if (!(haloWidth > T(0)))
+    {
+        FORTUNE_STATISTICS(mDiagram.mStatistics.constructTime += FortuneStatistics::getElapsedTime(start));
+        construct();
+        return;
+    }
+    // Build the strips independently
+    mStrips.resize(nbStrips);
+    parallelFor(nbStrips, nbStrips, [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+            buildStrip(mStrips[i], i * nbSites / nbStrips, (i + 1) * nbSites / nbStrips, haloWidth);
+    });
+    // Stitch them, or fall back to the serial construction if they are not consistent
+    mBeachline.clear();
+    bool isMerged = mergeStrips(nbThreads);
+#if FORTUNE_ENABLE_STATISTICS
+    if (isMerged)
+    {
+        for (const Strip& strip : mStrips)
+            mDiagram.mStatistics.addEvents(strip.algorithm->mDiagram.mStatistics);
+    }
+    mDiagram.mStatistics.constructTime += FortuneStatistics::getElapsedTime(start);
+#endif
+    if (!isMerged)
+        construct();
+}
+
+template<typename T>
+auto BasicFortuneAlgorithm<T>::getDiagram() -> Diagram&
+{
+    return mDiagram;
+}
+
+template<typename T>
+auto BasicFortuneAlgorithm<T>::getDiagram() const -> const Diagram&
+{
+    return mDiagram;
+}
+
+template<typename T>
+void BasicFortuneAlgorithm<T>::setTriangulationEnabled(bool enabled)
+{
+    mIsTriangulationEnabled = enabled;
+}
+
+template<typename T>
+auto BasicFortuneAlgorithm<T>::getTriangles() const -> const std::vector<Index>&
+{
+    return mTriangles;
+}
+
+template<typename T>
+auto BasicFortuneAlgorithm<T>::getTriangleNeighbors() const -> const std::vector<Index>&
+{
+    return mTriangleNeighbors;
+}
+
+template<typename T>
+void BasicFortuneAlgorithm<T>::sortTiesByX()
+{
+    // Sites with the same y are sorted by x, so that the highest ones are added from left to right
+    std::size_t nbSites = mSiteOrder.size();
+    auto getPoint = [this](Index site) { return mDiagram.getSite(site)->point; };
+    for (std::size_t begin = 0, end = 1; end <= nbSites; ++end)
+    {
+        if (end == nbSites || getPoint(mSiteOrder[end]).y != getPoint(mSiteOrder[begin]).y)
+        {
+            if (end - begin > 1)
+                std::sort(mSiteOrder.begin() + begin, mSiteOrder.begin() + end, [&](Index lhs, Index rhs)
+                {
+                    return getPoint(lhs).x < getPoint(rhs).x;
+                });
+            begin = end;
+        }
+    }
+}
+
+template<typename T>
+void BasicFortuneAlgorithm<T>::sweep()
+{
+    // There are at most 2n - 5 triangles
+    if (mIsTriangulationEnabled)
+    {
+        mTriangles.reserve(6 * mSiteOrder.size());
+        mTriangleNeighbors.reserve(6 * mSiteOrder.size());
+    }
+    // Merge the sorted sites with the circle events, circle events go first in case of a tie
+    std::size_t i = 0;
+    while (i < mSiteOrder.size() || !mEvents.isEmpty())
+    {
+        if (i < mSiteOrder.size() && (mEvents.isEmpty() || mEvents.top().y < mDiagram.getSite(mSiteOrder[i])->point.y))
+        {
+            Site* site = mDiagram.getSite(mSiteOrder[i++]);
+            mBeachlineY = site->point.y;
+            handleSiteEvent(site);
+#if FORTUNE_ENABLE_STATISTICS
+            ++mDiagram.mStatistics.nbSiteEvents;
+            mDiagram.mStatistics.maxBeachlineSize = std::max(mDiagram.mStatistics.maxBeachlineSize, mBeachline.getNbArcs());
+#endif
+        }
         else
-            handleCircleEvent(event.get());
+        {
+            Event<T> event = mEvents.pop();
+            mBeachlineY = event.y;
+            handleCircleEvent(&event);
+            FORTUNE_STATISTICS(++mDiagram.mStatistics.nbCircleEvents);
+        }
+    }
+    // The sizes of these buffers vary the most between two runs
+    mBeachline.reserveHeadroom();
+    mEvents.reserveHeadroom();
+    reserveHeadroom(mTopEdges);
+}
+
+template<typename T>
+void BasicFortuneAlgorithm<T>::buildStrip(Strip& strip, std::size_t begin, std::size_t end, T haloWidth)
+{
+    constexpr Index NONE = Diagram::INVALID_INDEX;
+    if (!strip.algorithm)
+        strip.algorithm = std::make_unique<BasicFortuneAlgorithm>();
+    BasicFortuneAlgorithm& algorithm = *strip.algorithm;
+    algorithm.setTriangulationEnabled(true);
+    const std::vector<Index>& triangles = algorithm.getTriangles();
+    const std::vector<Index>& neighbors = algorithm.getTriangleNeighbors();
+    const Diagram& diagram = algorithm.getDiagram();
+    // Add the sites in the circumcircles of the owned triangles until they are the ones of the whole diagram,
+    // or widen the halo if there are too many of them
+    strip.extraRanks.clear();
+    while (true)
+    {
+        std::size_t haloBegin = std::lower_bound(mSortedPoints.begin(), mSortedPoints.begin() + begin,
+            mSortedPoints[begin].x - haloWidth, [](const Vector2& point, T x) { return point.x < x; }) - mSortedPoints.begin();
+        std::size_t haloEnd = std::upper_bound(mSortedPoints.begin() + end, mSortedPoints.end(),
+            mSortedPoints[end - 1].x + haloWidth, [](T x, const Vector2& point) { return x < point.x; }) - mSortedPoints.begin();
+        bool isComplete = haloBegin == 0 && haloEnd == mSortedPoints.size();
+        strip.ranks.clear();
+        for (Index rank : mHullRanks)
+        {
+            if (rank < haloBegin || rank >= haloEnd)
+                strip.ranks.push_back(rank);
+        }
+        for (Index rank : strip.extraRanks)
+        {
+            if (rank < haloBegin || rank >= haloEnd)
+                strip.ranks.push_back(rank);
+        }
+        for (std::size_t rank = haloBegin; rank < haloEnd; ++rank)
+            strip.ranks.push_back(static_cast<Index>(rank));
+        strip.points.resize(strip.ranks.size());
+        for (std::size_t i = 0; i < strip.ranks.size(); ++i)
+            strip.points[i] = mSortedPoints[strip.ranks[i]];
+        algorithm.reset(strip.points);
+        algorithm.construct();
+        // A triangle belongs to the strip of its first site in x order which is not on the hull
+        std::size_t nbTriangles = triangles.size() / 3;
+        Index nbOwnedTriangles = 0;
+        strip.ownedTriangles.resize(nbTriangles);
+        std::size_t nbExtraRanks = strip.extraRanks.size();
+        for (std::size_t t = 0; t < nbTriangles; ++t)
+        {
+            Index first = NONE;
+            Index firstOnHull = NONE;
+            for (std::size_t k = 0; k < 3; ++k)
+            {
+                Index rank = strip.ranks[triangles[3 * t + k]];
+                if (mIsOnHull[rank])
+                    firstOnHull = std::min(firstOnHull, rank);
+                else
+                    first = std::min(first, rank);
+            }
+            if (first == NONE)
+                first = firstOnHull;
+            if (first < begin || first >= end)
+            {
+                strip.ownedTriangles[t] = NONE;
+                continue;
+            }
+            strip.ownedTriangles[t] = nbOwnedTriangles++;
+            // No other site may be in the circumcircle
+            if (!isComplete)
+            {
+                Vector2 center = diagram.getVertex(static_cast<Index>(t)).point;
+                Vector2 radius = strip.points[triangles[3 * t]] - center;
+                addSitesInCircle(center, radius.dot(radius), haloBegin, haloEnd, strip.extraRanks);
+            }
+        }
+        std::sort(strip.extraRanks.begin(), strip.extraRanks.end());
+        strip.extraRanks.erase(std::unique(strip.extraRanks.begin(), strip.extraRanks.end()), strip.extraRanks.end());
+        if (strip.extraRanks.size() == nbExtraRanks)
+            break;
+        if (strip.extraRanks.size() > (end - begin) / 4)
+        {
+            strip.extraRanks.clear();
+            haloWidth *= T(2);
+        }
+    }
+    // Keep the owned triangles
+    strip.triangles.clear();
+    strip.neighbors.clear();
+    strip.vertices.clear();
+    strip.crossEdges.clear();
+    strip.hullSides.clear();
+    for (std::size_t t = 0; t < strip.ownedTriangles.size(); ++t)
+    {
+        Index owned = strip.ownedTriangles[t];
+        if (owned == NONE)
+            continue;
+        for (std::size_t k = 0; k < 3; ++k)
+            strip.triangles.push_back(mSiteOrder[strip.ranks[triangles[3 * t + k]]]);
+        strip.vertices.push_back(diagram.getVertex(static_cast<Index>(t)).point);
+        for (std::size_t k = 0; k < 3; ++k)
+        {
+            Index side = static_cast<Index>(3 * owned + k);
+            Index neighbor = neighbors[3 * t + k];
+            if (neighbor == NONE)
+                strip.hullSides.push_back(side);
+            else if (strip.ownedTriangles[neighbor] == NONE)
+            {
+                std::uint64_t site1 = mSiteOrder[strip.ranks[triangles[3 * t + (k + 1) % 3]]];
+                std::uint64_t site2 = mSiteOrder[strip.ranks[triangles[3 * t + (k + 2) % 3]]];
+                strip.crossEdges.push_back(CrossEdge{(std::min(site1, site2) << 32) | std::max(site1, site2), side});
+            }
+            strip.neighbors.push_back(neighbor != NONE ? strip.ownedTriangles[neighbor] : NONE);
+        }
+    }
+}
+
+template<typename T>
+void BasicFortuneAlgorithm<T>::addSitesInCircle(const Vector2& center, T squaredRadius, std::size_t begin, std::size_t end,
+    std::vector<Index>& ranks) const
+{
+    // Only the sites outside of [begin, end) and not on the hull are tested, block by block from the closest ones
+    T radius = std::sqrt(squaredRadius);
+    auto addBlock = [&](std::size_t blockBegin, std::size_t blockEnd)
+    {
+        const std::array<T, 2>& range = mBlockYRanges[blockBegin / BLOCK_SIZE];
+        T dx = std::max({mSortedPoints[blockBegin].x - center.x, center.x - mSortedPoints[blockEnd - 1].x, T(0)});
+        T dy = std::max({range[0] - center.y, center.y - range[1], T(0)});
+        if (dx * dx + dy * dy >= squaredRadius)
+            return;
+        for (std::size_t i = blockBegin; i < blockEnd; ++i)
+        {
+            Vector2 offset = mSortedPoints[i] - center;
+            if (offset.dot(offset) < squaredRadius && !mIsOnHull[i])
+                ranks.push_back(static_cast<Index>(i));
+        }
+    };
+    for (std::size_t blockEnd = begin; blockEnd > 0 && mSortedPoints[blockEnd - 1].x > center.x - radius;)
+    {
+        std::size_t blockBegin = (blockEnd - 1) / BLOCK_SIZE * BLOCK_SIZE;
+        addBlock(blockBegin, blockEnd);
+        blockEnd = blockBegin;
+    }
+    for (std::size_t blockBegin = end; blockBegin < mSortedPoints.size() && mSortedPoints[blockBegin].x < center.x + radius;)
+    {
+        std::size_t blockEnd = std::min((blockBegin / BLOCK_SIZE + 1) * BLOCK_SIZE, mSortedPoints.size());
+        addBlock(blockBegin, blockEnd);
+        blockBegin = blockEnd;
+    }
+}
+
+template<typename T>
+void BasicFortuneAlgorithm<T>::computeHull()
+{
+    // Monotone chain, the sites on the edges are kept
+    mHullRanks.clear();
+    auto isRightTurn = [this](Index a, Index b, std::size_t c)
+    {
+        return (mSortedPoints[b] - mSortedPoints[a]).getDet(mSortedPoints[c] - mSortedPoints[a]) < T(0);
+    };
+    auto addSite = [&](std::size_t rank, std::size_t chainBegin)
+    {
+        while (mHullRanks.size() >= chainBegin + 2 && isRightTurn(mHullRanks[mHullRanks.size() - 2], mHullRanks.back(), rank))
+            mHullRanks.pop_back();
+        mHullRanks.push_back(static_cast<Index>(rank));
+    };
+    for (std::size_t rank = 0; rank < mSortedPoints.size(); ++rank)
+        addSite(rank, 0);
+    std::size_t upperBegin = mHullRanks.size();
+    for (std::size_t rank = mSortedPoints.size(); rank-- > 0;)
+        addSite(rank, upperBegin);
+    mIsOnHull.assign(mSortedPoints.size(), false);
+    for (Index rank : mHullRanks)
+        mIsOnHull[rank] = true;
+    // Each site once, by increasing x
+    mHullRanks.clear();
+    for (std::size_t rank = 0; rank < mSortedPoints.size(); ++rank)
+    {
+        if (mIsOnHull[rank])
+            mHullRanks.push_back(static_cast<Index>(rank));
     }
 }
 
-VoronoiDiagram FortuneAlgorithm::getDiagram()
+template<typename T>
+bool BasicFortuneAlgorithm<T>::mergeStrips(std::size_t nbThreads)
 {
-    return std::move(mDiagram);
+    constexpr Index NONE = Diagram::INVALID_INDEX;
+    // Check that the strips form a triangulation with Euler's formula
+    std::size_t nbSites = mDiagram.getNbSites();
+    std::size_t nbTriangles = 0;
+    std::size_t nbHullSides = 0;
+    for (Strip& strip : mStrips)
+    {
+        strip.offset = nbTriangles;
+        nbTriangles += strip.vertices.size();
+        nbHullSides += strip.hullSides.size();
+    }
+    if (nbTriangles + nbHullSides + 2 != 2 * nbSites)
+        return false;
+    // The edges between two strips must be found once in each strip
+    mCrossEdges.clear();
+    for (const Strip& strip : mStrips)
+    {
+        for (const CrossEdge& edge : strip.crossEdges)
+            mCrossEdges.push_back(CrossEdge{edge.sites, static_cast<Index>(edge.side + 3 * strip.offset)});
+    }
+    std::sort(mCrossEdges.begin(), mCrossEdges.end(), [](const CrossEdge& lhs, const CrossEdge& rhs)
+    {
+        return lhs.sites < rhs.sites;
+    });
+    if (mCrossEdges.size() % 2 != 0)
+        return false;
+    for (std::size_t i = 0; i < mCrossEdges.size(); i += 2)
+    {
+        if (mCrossEdges[i].sites != mCrossEdges[i + 1].sites || (i + 2 < mCrossEdges.size() && mCrossEdges[i + 2].sites == mCrossEdges[i].sites))
+            return false;
+    }
+    // Concatenate the triangles
+    mTriangles.resize(3 * nbTriangles);
+    mTriangleNeighbors.resize(3 * nbTriangles);
+    mDiagram.mVertices.resize(nbTriangles);
+    FORTUNE_STATISTICS(mDiagram.mStatistics.nbCreatedVertices += nbTriangles);
+    parallelFor(nbThreads, mStrips.size(), [this](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const Strip& strip = mStrips[i];
+            std::copy(strip.triangles.begin(), strip.triangles.end(), mTriangles.begin() + 3 * strip.offset);
+            for (std::size_t j = 0; j < strip.neighbors.size(); ++j)
+            {
+                Index neighbor = strip.neighbors[j];
+                mTriangleNeighbors[3 * strip.offset + j] = neighbor != NONE ? static_cast<Index>(neighbor + strip.offset) : NONE;
+            }
+            for (std::size_t j = 0; j < strip.vertices.size(); ++j)
+                mDiagram.mVertices[strip.offset + j].point = strip.vertices[j];
+        }
+    });
+    for (std::size_t i = 0; i < mCrossEdges.size(); i += 2)
+    {
+        mTriangleNeighbors[mCrossEdges[i].side] = mCrossEdges[i + 1].side / 3;
+        mTriangleNeighbors[mCrossEdges[i + 1].side] = mCrossEdges[i].side / 3;
+    }
+    // Each side of a triangle has the half edge from its vertex to the vertex of the neighbor, in the face of the
+    // second site of the side, the half edges going out from the hull are appended
+    std::vector<typename Diagram::HalfEdge>& halfEdges = mDiagram.mHalfEdges;
+    halfEdges.clear();
+    halfEdges.resize(3 * nbTriangles + nbHullSides);
+    FORTUNE_STATISTICS(mDiagram.mStatistics.nbCreatedHalfEdges += 3 * nbTriangles + nbHullSides);
+    auto getFace = [this](Index site) { return mDiagram.getSite(site)->face; };
+    mUnboundedEdges.clear();
+    Index hullHalfEdge = static_cast<Index>(3 * nbTriangles);
+    for (const Strip& strip : mStrips)
+    {
+        for (Index side : strip.hullSides)
+        {
+            side += static_cast<Index>(3 * strip.offset);
+            Index triangle = side / 3;
+            Index leftSite = mTriangles[3 * triangle + (side + 1) % 3];
+            Index rightSite = mTriangles[3 * triangle + (side + 2) % 3];
+            halfEdges[hullHalfEdge].destination = triangle;
+            halfEdges[hullHalfEdge].twin = side;
+            halfEdges[hullHalfEdge].incidentFace = getFace(leftSite);
+            halfEdges[side].twin = hullHalfEdge;
+            mUnboundedEdges.push_back(UnboundedEdge{leftSite, rightSite, hullHalfEdge, side});
+            ++hullHalfEdge;
+        }
+    }
+    parallelFor(nbThreads, nbTriangles, [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t t = begin; t < end; ++t)
+        {
+            for (std::size_t k = 0; k < 3; ++k)
+            {
+                typename Diagram::HalfEdge& halfEdge = halfEdges[3 * t + k];
+                Index neighbor = mTriangleNeighbors[3 * t + k];
+                halfEdge.origin = static_cast<Index>(t);
+                halfEdge.destination = neighbor;
+                halfEdge.incidentFace = getFace(mTriangles[3 * t + (k + 2) % 3]);
+                if (neighbor != NONE)
+                {
+                    std::size_t m = mTriangleNeighbors[3 * neighbor] == t ? 0 : (mTriangleNeighbors[3 * neighbor + 1] == t ? 1 : 2);
+                    halfEdge.twin = static_cast<Index>(3 * neighbor + m);
+                }
+            }
+            // Around the site i, the half edge of side i + 2 comes to the vertex and the one of side i + 1 leaves it
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                Index outgoing = static_cast<Index>(3 * t + (i + 1) % 3);
+                Index incoming = halfEdges[3 * t + (i + 2) % 3].twin;
+                halfEdges[incoming].next = outgoing;
+                halfEdges[outgoing].prev = incoming;
+            }
+        }
+    });
+    for (std::size_t i = 0; i < 3 * nbTriangles; ++i)
+        mDiagram.getFace(halfEdges[i].incidentFace)->outerComponent = static_cast<Index>(i);
+    if (!mIsTriangulationEnabled)
+    {
+        mTriangles.clear();
+        mTriangleNeighbors.clear();
+    }
+    return true;
 }
 
-void FortuneAlgorithm::handleSiteEvent(Event* event)
+template<typename T>
+void BasicFortuneAlgorithm<T>::handleSiteEvent(Site* site)
 {
-    VoronoiDiagram::Site* site = event->site;
     // 1. Check if the bachline is empty
     if (mBeachline.isEmpty())
     {
@@ -60,266 +582,413 @@ void FortuneAlgorithm::handleSiteEvent(Event* event)
         return;
     }
     // 2. Look for the arc above the site
-    Arc* arcToBreak = mBeachline.locateArcAbove(site->point, mBeachlineY);
+    Arc<T>* arcToBreak = mBeachline.locateArcAbove(site->point, mBeachlineY);
+#if FORTUNE_ENABLE_STATISTICS
+    ++mDiagram.mStatistics.nbArcLocations;
+    mDiagram.mStatistics.totalArcLocationDepth += mBeachline.getLastLocationDepth();
+    mDiagram.mStatistics.maxArcLocationDepth = std::max(mDiagram.mStatistics.maxArcLocationDepth,
+        mBeachline.getLastLocationDepth());
+#endif
+    // The highest sites are all on the sweep line, the new arc is added on the right of the last one
+    if (arcToBreak->site->point.y == site->point.y)
+    {
+        Arc<T>* rightArc = mBeachline.createArc(site);
+        mBeachline.insertAfter(arcToBreak, rightArc);
+        addEdge(arcToBreak, rightArc);
+        // The edge goes up to infinity, seen from above its sites are swapped
+        mTopEdges.push_back(UnboundedEdge{site->index, arcToBreak->site->index,
+            rightArc->leftHalfEdge, arcToBreak->rightHalfEdge});
+        return;
+    }
     deleteEvent(arcToBreak);
     // 3. Replace this arc by the new arcs
-    Arc* middleArc = breakArc(arcToBreak, site);
-    Arc* leftArc = middleArc->prev; 
-    Arc* rightArc = middleArc->next;
+    Arc<T>* middleArc = breakArc(arcToBreak, site);
+    Arc<T>* leftArc = middleArc->prev; 
+    Arc<T>* rightArc = middleArc->next;
     // 4. Add an edge in the diagram
     addEdge(leftArc, middleArc);
     middleArc->rightHalfEdge = middleArc->leftHalfEdge;
     rightArc->leftHalfEdge = leftArc->rightHalfEdge;
-    // 5. Check circle events
-    // Left triplet
-    if (!mBeachline.isNil(leftArc->prev))
+    // 5. Check circle events of the left and right triplets, together if both exist
+    bool hasLeftTriplet = !mBeachline.isNil(leftArc->prev);
+    bool hasRightTriplet = !mBeachline.isNil(rightArc->next);
+    if (hasLeftTriplet && hasRightTriplet)
+        addEvents({leftArc->prev, leftArc, middleArc}, {middleArc, rightArc, rightArc->next});
+    else if (hasLeftTriplet)
         addEvent(leftArc->prev, leftArc, middleArc);
-    // Right triplet
-    if (!mBeachline.isNil(rightArc->next))
+    else if (hasRightTriplet)
         addEvent(middleArc, rightArc, rightArc->next);
 }
 
-void FortuneAlgorithm::handleCircleEvent(Event* event)
+template<typename T>
+void BasicFortuneAlgorithm<T>::handleCircleEvent(Event<T>* event)
 {
     Vector2 point = event->point;
-    Arc* arc = event->arc;
+    Arc<T>* arc = event->arc;
     // 1. Add vertex
-    VoronoiDiagram::Vertex* vertex = mDiagram.createVertex(point);
+    Index vertex = mDiagram.createVertex(point);
+    Arc<T>* leftArc = arc->prev;
+    Arc<T>* rightArc = arc->next;
+    if (mIsTriangulationEnabled)
+        addTriangle(leftArc, arc, rightArc);
     // 2. Delete all the events with this arc
-    Arc* leftArc = arc->prev;
-    Arc* rightArc = arc->next;
     deleteEvent(leftArc);
     deleteEvent(rightArc);
     // 3. Update the beachline and the diagram
     removeArc(arc, vertex);
-    // 4. Add new circle events
-    // Left triplet
-    if (!mBeachline.isNil(leftArc->prev))
+    // 4. Add new circle events of the left and right triplets, together if both exist
+    bool hasLeftTriplet = !mBeachline.isNil(leftArc->prev);
+    bool hasRightTriplet = !mBeachline.isNil(rightArc->next);
+    if (hasLeftTriplet && hasRightTriplet)
+        addEvents({leftArc->prev, leftArc, rightArc}, {leftArc, rightArc, rightArc->next});
+    else if (hasLeftTriplet)
         addEvent(leftArc->prev, leftArc, rightArc);
-    // Right triplet
-    if (!mBeachline.isNil(rightArc->next))
+    else if (hasRightTriplet)
         addEvent(leftArc, rightArc, rightArc->next);
 }
 
-Arc* FortuneAlgorithm::breakArc(Arc* arc, VoronoiDiagram::Site* site)
+template<typename T>
+Arc<T>* BasicFortuneAlgorithm<T>::breakArc(Arc<T>* arc, Site* site)
 {
     // Create the new subtree
-    Arc* middleArc = mBeachline.createArc(site);
-    Arc* leftArc = mBeachline.createArc(arc->site);
+    Arc<T>* middleArc = mBeachline.createArc(site);
+    Arc<T>* leftArc = mBeachline.createArc(arc->site);
     leftArc->leftHalfEdge = arc->leftHalfEdge;
-    Arc* rightArc = mBeachline.createArc(arc->site);
+    Arc<T>* rightArc = mBeachline.createArc(arc->site);
     rightArc->rightHalfEdge = arc->rightHalfEdge;
     // Insert the subtree in the beachline
     mBeachline.replace(arc, middleArc);
     mBeachline.insertBefore(middleArc, leftArc);
     mBeachline.insertAfter(middleArc, rightArc);
     // Delete old arc
-    delete arc;
+    mBeachline.deleteArc(arc);
     // Return the middle arc
     return middleArc;
 }
 
-void FortuneAlgorithm::removeArc(Arc* arc, VoronoiDiagram::Vertex* vertex)
+template<typename T>
+void BasicFortuneAlgorithm<T>::removeArc(Arc<T>* arc, Index vertex)
 {
     // End edges
     setDestination(arc->prev, arc, vertex);
     setDestination(arc, arc->next, vertex);
     // Join the edges of the middle arc
-    arc->leftHalfEdge->next = arc->rightHalfEdge;
-    arc->rightHalfEdge->prev = arc->leftHalfEdge;
+    setPrevHalfEdge(arc->leftHalfEdge, arc->rightHalfEdge);
     // Update beachline
     mBeachline.remove(arc);
     // Create a new edge
-    VoronoiDiagram::HalfEdge* prevHalfEdge = arc->prev->rightHalfEdge;
-    VoronoiDiagram::HalfEdge* nextHalfEdge = arc->next->leftHalfEdge;
+    Index prevHalfEdge = arc->prev->rightHalfEdge;
+    Index nextHalfEdge = arc->next->leftHalfEdge;
     addEdge(arc->prev, arc->next);
     setOrigin(arc->prev, arc->next, vertex);
     setPrevHalfEdge(arc->prev->rightHalfEdge, prevHalfEdge);
     setPrevHalfEdge(nextHalfEdge, arc->next->leftHalfEdge);
     // Delete node
-    delete arc;
+    mBeachline.deleteArc(arc);
 }
 
-bool FortuneAlgorithm::isMovingRight(const Arc* left, const Arc* right) const
+template<typename T>
+void BasicFortuneAlgorithm<T>::addEdge(Arc<T>* left, Arc<T>* right)
 {
-    return left->site->point.y < right->site->point.y;
+    // Create two new half edges
+    left->rightHalfEdge = mDiagram.createHalfEdge(left->site->face);
+    right->leftHalfEdge = mDiagram.createHalfEdge(right->site->face);
+    // Set the two half edges twins
+    mDiagram.mHalfEdges[left->rightHalfEdge].twin = right->leftHalfEdge;
+    mDiagram.mHalfEdges[right->leftHalfEdge].twin = left->rightHalfEdge;
 }
 
-double FortuneAlgorithm::getInitialX(const Arc* left, const Arc* right, bool movingRight) const
+template<typename T>
+void BasicFortuneAlgorithm<T>::setOrigin(Arc<T>* left, Arc<T>* right, Index vertex)
 {
-    return movingRight ? left->site->point.x : right->site->point.x;
+    mDiagram.mHalfEdges[left->rightHalfEdge].destination = vertex;
+    mDiagram.mHalfEdges[right->leftHalfEdge].origin = vertex;
 }
 
-void FortuneAlgorithm::addEdge(Arc* left, Arc* right)
+template<typename T>
+void BasicFortuneAlgorithm<T>::setDestination(Arc<T>* left, Arc<T>* right, Index vertex)
 {
-    // Create two new half edges
-    left->rightHalfEdge = mDiagram.createHalfEdge(left->site->face);
-    right->leftHalfEdge = mDiagram.createHalfEdge(right->site->face);
-    // Set the two half edges twins
-    left->rightHalfEdge->twin = right->leftHalfEdge;
-    right->leftHalfEdge->twin = left->rightHalfEdge;
+    mDiagram.mHalfEdges[left->rightHalfEdge].origin = vertex;
+    mDiagram.mHalfEdges[right->leftHalfEdge].destination = vertex;
 }
 
-void FortuneAlgorithm::setOrigin(Arc* left, Arc* right, VoronoiDiagram::Vertex* vertex)
+template<typename T>
+void BasicFortuneAlgorithm<T>::setPrevHalfEdge(Index prev, Index next)
 {
-    left->rightHalfEdge->destination = vertex;
-    right->leftHalfEdge->origin = vertex;
+    mDiagram.mHalfEdges[prev].next = next;
+    mDiagram.mHalfEdges[next].prev = prev;
 }
 
-void FortuneAlgorithm::setDestination(Arc* left, Arc* right, VoronoiDiagram::Vertex* vertex)
+template<typename T>
+void BasicFortuneAlgorithm<T>::addTriangle(const Arc<T>* left, const Arc<T>* middle, const Arc<T>* right)
 {
-    left->rightHalfEdge->origin = vertex;
-    right->leftHalfEdge->destination = vertex;
+    // The middle arc disappears between the two others, so left, right, middle is counterclockwise
+    Index triangle = static_cast<Index>(mTriangles.size() / 3);
+    mTriangles.insert(mTriangles.end(), {left->site->index, right->site->index, middle->site->index});
+    mTriangleNeighbors.insert(mTriangleNeighbors.end(), 3, Diagram::INVALID_INDEX);
+    // The edges ending at this vertex are shared with the triangles of the vertices where they started
+    linkTriangles(triangle, 1, left->rightHalfEdge);
+    linkTriangles(triangle, 0, middle->rightHalfEdge);
 }
 
-void FortuneAlgorithm::setPrevHalfEdge(VoronoiDiagram::HalfEdge* prev, VoronoiDiagram::HalfEdge* next)
+template<typename T>
+void BasicFortuneAlgorithm<T>::linkTriangles(Index triangle, int side, Index halfEdge)
 {
-    prev->next = next;
-    next->prev = prev;
+    Index neighbor = mDiagram.mHalfEdges[halfEdge].destination;
+    if (neighbor == Diagram::INVALID_INDEX)
+        return;
+    // The side of the neighbor is the one of the site that is not on the edge
+    Index site1 = mTriangles[3 * triangle + (side + 1) % 3];
+    Index site2 = mTriangles[3 * triangle + (side + 2) % 3];
+    for (int k = 0; k < 3; ++k)
+    {
+        Index site = mTriangles[3 * neighbor + k];
+        if (site != site1 && site != site2)
+        {
+            mTriangleNeighbors[3 * neighbor + k] = triangle;
+            break;
+        }
+    }
+    mTriangleNeighbors[3 * triangle + side] = neighbor;
 }
 
-void FortuneAlgorithm::addEvent(Arc* left, Arc* middle, Arc* right)
+template<typename T>
+void BasicFortuneAlgorithm<T>::addEvent(Arc<T>* left, Arc<T>* middle, Arc<T>* right)
 {
+    Vector2 center;
     double y;
-    Vector2 convergencePoint = computeConvergencePoint(left->site->point, middle->site->point, right->site->point, y);
-    bool isBelow = y <= mBeachlineY;
-    bool leftBreakpointMovingRight = isMovingRight(left, middle);
-    bool rightBreakpointMovingRight = isMovingRight(middle, right);
-    double leftInitialX = getInitialX(left, middle, leftBreakpointMovingRight);
-    double rightInitialX = getInitialX(middle, right, rightBreakpointMovingRight);
-    bool isValid =
-        ((leftBreakpointMovingRight && leftInitialX < convergencePoint.x) ||
-        (!leftBreakpointMovingRight && leftInitialX > convergencePoint.x)) &&
-        ((rightBreakpointMovingRight && rightInitialX < convergencePoint.x) ||
-        (!rightBreakpointMovingRight && rightInitialX > convergencePoint.x));
-    if (isValid && isBelow)
+    if (computeCircleEvent(left->site->point, middle->site->point, right->site->point, mBeachlineY, center, y))
     {
-        std::unique_ptr<Event> event = std::make_unique<Event>(y, convergencePoint, middle);
-        middle->event = event.get();
-        mEvents.push(std::move(event));
+        middle->event = mEvents.push(Event<T>(y, center, middle));
+        FORTUNE_STATISTICS(++mDiagram.mStatistics.nbCreatedCircleEvents);
     }
 }
 
-void FortuneAlgorithm::deleteEvent(Arc* arc)
+template<typename T>
+void BasicFortuneAlgorithm<T>::addEvents(const std::array<Arc<T>*, 3>& leftTriplet, const std::array<Arc<T>*, 3>& rightTriplet)
 {
-    if (arc->event != nullptr)
-    {
-        mEvents.remove(arc->event->index);
-        arc->event = nullptr;
-    }
+    std::array<Vector2, 2> centers;
+    std::array<double, 2> ys;
+    unsigned int exists = computeCircleEvents({{
+        {&leftTriplet[0]->site->point, &leftTriplet[1]->site->point, &leftTriplet[2]->site->point},
+        {&rightTriplet[0]->site->point, &rightTriplet[1]->site->point, &rightTriplet[2]->site->point}}},
+        mBeachlineY, centers, ys);
+    FORTUNE_STATISTICS(mDiagram.mStatistics.nbCreatedCircleEvents += (exists & 1u) + ((exists >> 1) & 1u));
+    if (exists & 1u)
+        leftTriplet[1]->event = mEvents.push(Event<T>(ys[0], centers[0], leftTriplet[1]));
+    if (exists & 2u)
+        rightTriplet[1]->event = mEvents.push(Event<T>(ys[1], centers[1], rightTriplet[1]));
 }
 
-Vector2 FortuneAlgorithm::computeConvergencePoint(const Vector2& point1, const Vector2& point2, const Vector2& point3, double& y) const
+template<typename T>
+void BasicFortuneAlgorithm<T>::deleteEvent(Arc<T>* arc)
 {
-    Vector2 v1 = (point1 - point2).getOrthogonal();
-    Vector2 v2 = (point2 - point3).getOrthogonal();
-    Vector2 delta = 0.5 * (point3 - point1);
-    double t = delta.getDet(v2) / v1.getDet(v2);
-    Vector2 center = 0.5 * (point1 + point2) + t * v1;
-    double r = center.getDistance(point1);
-    y = center.y - r;
-    return center;
+    if (arc->event != PriorityQueue<Event<T>>::INVALID_HANDLE)
+    {
+        mEvents.remove(arc->event);
+        arc->event = PriorityQueue<Event<T>>::INVALID_HANDLE;
+        FORTUNE_STATISTICS(++mDiagram.mStatistics.nbDeletedCircleEvents);
+    }
 }
 
 // Bound
 
-#include <list>
-#include <unordered_map>
+template<typename T>
+void BasicFortuneAlgorithm<T>::collectUnboundedEdges()
+{
+    // Retrieve all non bounded half edges from the beach line, the parallel construction fills them directly
+    if (!mBeachline.isEmpty())
+    {
+        mUnboundedEdges.clear();
+        Arc<T>* leftArc = mBeachline.getLeftmostArc();
+        Arc<T>* rightArc = leftArc->next;
+        while (!mBeachline.isNil(rightArc))
+        {
+            mUnboundedEdges.push_back(UnboundedEdge{leftArc->site->index, rightArc->site->index,
+                leftArc->rightHalfEdge, rightArc->leftHalfEdge});
+            // Next edge
+            leftArc = rightArc;
+            rightArc = rightArc->next;
+        }
+        mUnboundedEdges.insert(mUnboundedEdges.end(), mTopEdges.begin(), mTopEdges.end());
+    }
+}
 
-bool FortuneAlgorithm::bound(Box box)
+template<typename T>
+bool BasicFortuneAlgorithm<T>::clip(Box box)
 {
+    // The unbounded edges are ended on a box far around the vertices and the sites, the intersection with box then
+    // removes these ends, so the cells are closed directly on box without the corners and the edges added by bound
+    FORTUNE_STATISTICS(auto start = FortuneStatistics::Clock::now());
+    collectUnboundedEdges();
+    Box farBox = box;
+    auto extend = [&farBox](const Vector2& point)
+    {
+        farBox.left = std::min(point.x, farBox.left);
+        farBox.bottom = std::min(point.y, farBox.bottom);
+        farBox.right = std::max(point.x, farBox.right);
+        farBox.top = std::max(point.y, farBox.top);
+    };
+    for (const auto& vertex : mDiagram.getVertices())
+        extend(vertex.point);
+    for (const UnboundedEdge& edge : mUnboundedEdges)
+    {
+        extend(mDiagram.getSite(edge.leftSite)->point);
+        extend(mDiagram.getSite(edge.rightSite)->point);
+    }
+    T margin = std::max({farBox.right - farBox.left, farBox.top - farBox.bottom, T(1)});
+    farBox = Box{farBox.left - margin, farBox.bottom - margin, farBox.right + margin, farBox.top + margin};
+    std::vector<typename Diagram::HalfEdge>& halfEdges = mDiagram.mHalfEdges;
+    auto isFarVertex = [firstFarVertex = mDiagram.getVertices().size()](Index vertex)
+    {
+        return vertex != Diagram::INVALID_INDEX && vertex >= firstFarVertex;
+    };
+    auto getLastHalfEdge = [&halfEdges](Index halfEdge)
+    {
+        while (halfEdges[halfEdge].next != Diagram::INVALID_INDEX)
+            halfEdge = halfEdges[halfEdge].next;
+        return halfEdge;
+    };
+    for (const UnboundedEdge& edge : mUnboundedEdges)
+    {
+        const Site* leftSite = mDiagram.getSite(edge.leftSite);
+        const Site* rightSite = mDiagram.getSite(edge.rightSite);
+        Vector2 direction = (leftSite->point - rightSite->point).getOrthogonal();
+        Vector2 origin = (leftSite->point + rightSite->point) * T(0.5);
+        Index vertex = mDiagram.createVertex(farBox.getFirstIntersection(origin, direction).point);
+        halfEdges[edge.leftHalfEdge].origin = vertex;
+        halfEdges[edge.rightHalfEdge].destination = vertex;
+        // The open cycle of the face starts with the half edge coming from infinity
+        typename Diagram::Face* face = mDiagram.getFace(leftSite->face);
+        Index otherStart = face->outerComponent;
+        if (isFarVertex(halfEdges[otherStart].origin))
+        {
+            // If the sites are collinear, a face can be a strip with two open cycles, they are joined in one
+            Index otherEnd = getLastHalfEdge(otherStart);
+            Index end = getLastHalfEdge(edge.leftHalfEdge);
+            halfEdges[otherEnd].next = edge.leftHalfEdge;
+            halfEdges[edge.leftHalfEdge].prev = otherEnd;
+            halfEdges[end].next = otherStart;
+            halfEdges[otherStart].prev = end;
+        }
+        else
+            face->outerComponent = edge.leftHalfEdge;
+    }
+    FORTUNE_STATISTICS(mDiagram.mStatistics.boundTime += FortuneStatistics::getElapsedTime(start));
+    return mDiagram.intersect(box);
+}
+
+template<typename T>
+bool BasicFortuneAlgorithm<T>::bound(Box box)
+{
+    FORTUNE_STATISTICS(auto start = FortuneStatistics::Clock::now());
     // Make sure the bounding box contains all the vertices
-    for (const auto& vertex : mDiagram.getVertices()) // Much faster when using vector<unique_ptr<Vertex*>, maybe we can test vertices in border cells to speed up
+    for (const auto& vertex : mDiagram.getVertices()) // Maybe we can test vertices in border cells to speed up
     {
         box.left = std::min(vertex.point.x, box.left);
         box.bottom = std::min(vertex.point.y, box.bottom);
         box.right = std::max(vertex.point.x, box.right);
         box.top = std::max(vertex.point.y, box.top);
     }
-    // Retrieve all non bounded half edges from the beach line
-    std::list<LinkedVertex> linkedVertices;
-    std::unordered_map<std::size_t, std::array<LinkedVertex*, 8>> vertices(mDiagram.getNbSites());
-    if (!mBeachline.isEmpty())
+    // Linked vertices are referred to by their index in mLinkedVertices, the scratch buffers are kept between runs
+    constexpr Index NONE = Diagram::INVALID_INDEX;
+    std::array<Index, 8> noVertices;
+    noVertices.fill(NONE);
+    mLinkedVertices.clear();
+    mBorderSites.clear();
+    mCellVertices.resize(mDiagram.getNbSites(), noVertices);
+    auto addLinkedVertex = [this](LinkedVertex linkedVertex)
     {
-        Arc* leftArc = mBeachline.getLeftmostArc();
-        Arc* rightArc = leftArc->next;
-        while (!mBeachline.isNil(rightArc))
-        {
-            // Bound the edge
-            Vector2 direction = (leftArc->site->point - rightArc->site->point).getOrthogonal();
-            Vector2 origin = (leftArc->site->point + rightArc->site->point) * 0.5f;
-            // Line-box intersection
-            Box::Intersection intersection = box.getFirstIntersection(origin, direction);
-            // Create a new vertex and ends the half edges
-            VoronoiDiagram::Vertex* vertex = mDiagram.createVertex(intersection.point);
-            setDestination(leftArc, rightArc, vertex);
-            // Initialize pointers
-            if (vertices.find(leftArc->site->index) == vertices.end()) 
-                vertices[leftArc->site->index].fill(nullptr); 
-            if (vertices.find(rightArc->site->index) == vertices.end()) 
-                vertices[rightArc->site->index].fill(nullptr); 
-            // Store the vertex on the boundaries
-            linkedVertices.emplace_back(LinkedVertex{nullptr, vertex, leftArc->rightHalfEdge});
-            vertices[leftArc->site->index][2 * static_cast<int>(intersection.side) + 1] = &linkedVertices.back();
-            linkedVertices.emplace_back(LinkedVertex{rightArc->leftHalfEdge, vertex, nullptr});
-            vertices[rightArc->site->index][2 * static_cast<int>(intersection.side)] = &linkedVertices.back();
-            // Next edge
-            leftArc = rightArc;
-            rightArc = rightArc->next;
-        }
+        mLinkedVertices.push_back(linkedVertex);
+        return static_cast<Index>(mLinkedVertices.size() - 1);
+    };
+    auto getCellVertices = [this](Index site) -> std::array<Index, 8>&
+    {
+        std::array<Index, 8>& cellVertices = mCellVertices[site];
+        if (std::all_of(cellVertices.begin(), cellVertices.end(), [](Index i){ return i == Diagram::INVALID_INDEX; }))
+            mBorderSites.push_back(site);
+        return cellVertices;
+    };
+    collectUnboundedEdges();
+    for (const UnboundedEdge& edge : mUnboundedEdges)
+    {
+        const Site* leftSite = mDiagram.getSite(edge.leftSite);
+        const Site* rightSite = mDiagram.getSite(edge.rightSite);
+        // Bound the edge
+        Vector2 direction = (leftSite->point - rightSite->point).getOrthogonal();
+        Vector2 origin = (leftSite->point + rightSite->point) * T(0.5);
+        // Line-box intersection
+        typename Box::Intersection intersection = box.getFirstIntersection(origin, direction);
+        // Create a new vertex and ends the half edges
+        Index vertex = mDiagram.createVertex(intersection.point);
+        mDiagram.mHalfEdges[edge.leftHalfEdge].origin = vertex;
+        mDiagram.mHalfEdges[edge.rightHalfEdge].destination = vertex;
+        // Store the vertex on the boundaries
+        Index leftVertex = addLinkedVertex(LinkedVertex{NONE, vertex, edge.leftHalfEdge});
+        getCellVertices(edge.leftSite)[2 * static_cast<int>(intersection.side) + 1] = leftVertex;
+        Index rightVertex = addLinkedVertex(LinkedVertex{edge.rightHalfEdge, vertex, NONE});
+        getCellVertices(edge.rightSite)[2 * static_cast<int>(intersection.side)] = rightVertex;
     }
     // Add corners
-    for (auto& kv : vertices)
+    for (Index site : mBorderSites)
     {
-        auto& cellVertices = kv.second;
+        auto& cellVertices = mCellVertices[site];
         // We check twice the first side to be sure that all necessary corners are added
         for (std::size_t i = 0; i < 5; ++i)
         {
             std::size_t side = i % 4;
             std::size_t nextSide = (side + 1) % 4;
             // Add first corner
-            if (cellVertices[2 * side] == nullptr && cellVertices[2 * side + 1] != nullptr)
+            if (cellVertices[2 * side] == NONE && cellVertices[2 * side + 1] != NONE)
             {
                 std::size_t prevSide = (side + 3) % 4;
-                VoronoiDiagram::Vertex* corner = mDiagram.createCorner(box, static_cast<Box::Side>(side));
-                linkedVertices.emplace_back(LinkedVertex{nullptr, corner, nullptr});
-                cellVertices[2 * prevSide + 1] = &linkedVertices.back();
-                cellVertices[2 * side] = &linkedVertices.back();
+                Index corner = mDiagram.createCorner(box, static_cast<typename Box::Side>(side));
+                Index linkedCorner = addLinkedVertex(LinkedVertex{NONE, corner, NONE});
+                cellVertices[2 * prevSide + 1] = linkedCorner;
+                cellVertices[2 * side] = linkedCorner;
             }
             // Add second corner
-            else if (cellVertices[2 * side] != nullptr && cellVertices[2 * side + 1] == nullptr)
+            else if (cellVertices[2 * side] != NONE && cellVertices[2 * side + 1] == NONE)
             {
-                VoronoiDiagram::Vertex* corner = mDiagram.createCorner(box, static_cast<Box::Side>(nextSide));
-                linkedVertices.emplace_back(LinkedVertex{nullptr, corner, nullptr});
-                cellVertices[2 * side + 1] = &linkedVertices.back();
-                cellVertices[2 * nextSide] = &linkedVertices.back();
+                Index corner = mDiagram.createCorner(box, static_cast<typename Box::Side>(nextSide));
+                Index linkedCorner = addLinkedVertex(LinkedVertex{NONE, corner, NONE});
+                cellVertices[2 * side + 1] = linkedCorner;
+                cellVertices[2 * nextSide] = linkedCorner;
             }
         }
     }
     // Join the half edges
-    for (auto& kv : vertices)
+    for (Index site : mBorderSites)
     {
-        std::size_t i = kv.first;
-        auto& cellVertices = kv.second;
+        auto& cellVertices = mCellVertices[site];
         for (std::size_t side = 0; side < 4; ++side)
         {
-            if (cellVertices[2 * side] != nullptr)
+            if (cellVertices[2 * side] != NONE)
             {
                 // Link vertices 
-                VoronoiDiagram::HalfEdge* halfEdge = mDiagram.createHalfEdge(mDiagram.getFace(i));
-                halfEdge->origin = cellVertices[2 * side]->vertex;
-                halfEdge->destination = cellVertices[2 * side + 1]->vertex;
-                cellVertices[2 * side]->nextHalfEdge = halfEdge;
-                halfEdge->prev = cellVertices[2 * side]->prevHalfEdge;
-                if (cellVertices[2 * side]->prevHalfEdge != nullptr)
-                    cellVertices[2 * side]->prevHalfEdge->next = halfEdge;
-                cellVertices[2 * side + 1]->prevHalfEdge = halfEdge;
-                halfEdge->next = cellVertices[2 * side + 1]->nextHalfEdge;
-                if (cellVertices[2 * side + 1]->nextHalfEdge != nullptr)
-                    cellVertices[2 * side + 1]->nextHalfEdge->prev = halfEdge;
+                LinkedVertex& start = mLinkedVertices[cellVertices[2 * side]];
+                LinkedVertex& end = mLinkedVertices[cellVertices[2 * side + 1]];
+                Index halfEdge = mDiagram.createHalfEdge(mDiagram.getSite(site)->face);
+                mDiagram.mHalfEdges[halfEdge].origin = start.vertex;
+                mDiagram.mHalfEdges[halfEdge].destination = end.vertex;
+                start.nextHalfEdge = halfEdge;
+                mDiagram.mHalfEdges[halfEdge].prev = start.prevHalfEdge;
+                if (start.prevHalfEdge != NONE)
+                    mDiagram.mHalfEdges[start.prevHalfEdge].next = halfEdge;
+                end.prevHalfEdge = halfEdge;
+                mDiagram.mHalfEdges[halfEdge].next = end.nextHalfEdge;
+                if (end.nextHalfEdge != NONE)
+                    mDiagram.mHalfEdges[end.nextHalfEdge].prev = halfEdge;
             }
         }
+        // Leave the slots empty for the next run
+        cellVertices = noVertices;
     }
+    FORTUNE_STATISTICS(mDiagram.mStatistics.boundTime += FortuneStatistics::getElapsedTime(start));
     return true; // TO DO: detect errors
 }
 
+// Explicit instantiations
+
+template class BasicFortuneAlgorithm<float>;
+template class BasicFortuneAlgorithm<double>;
@@ -17,62 +17,163 @@
 
 #pragma once
 
+// STL
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
 // My includes
+#include "Event.h"
 #include "PriorityQueue.h"
+#include "RadixSort.h"
 #include "VoronoiDiagram.h"
 #include "Beachline.h"
 
+template<typename T>
 struct Arc;
-class Event;
 
-class FortuneAlgorithm
+template<typename T>
+class BasicFortuneAlgorithm
 {
 public:
-    
-    FortuneAlgorithm(std::vector<Vector2> points);
-    ~FortuneAlgorithm();
+    using Vector2 = BasicVector2<T>;
+    using Box = BasicBox<T>;
+    using Diagram = BasicVoronoiDiagram<T>;
+    using Index = typename Diagram::Index;
+
+    BasicFortuneAlgorithm();
+    BasicFortuneAlgorithm(std::vector<Vector2> points);
+    ~BasicFortuneAlgorithm();
+
+    // Start a new diagram, all the buffers keep their capacity so that a warm context does not allocate
+    void reset(std::span<const Vector2> points);
 
     void construct();
+    // The points must be sorted by decreasing y, the sites with the same y can be in any order
+    void constructFromSorted();
+    // The sites are split in vertical strips built concurrently then stitched together
+    // The cells are the same as with construct(), only the order of the elements in the diagram differs
+    void constructParallel(std::size_t nbThreads);
     bool bound(Box box);
+    // Bound the diagram and intersect it with box in one pass, same cells as bound with a larger box then intersect
+    bool clip(Box box);
+
+    // Move from the diagram to take its ownership
+    Diagram& getDiagram();
+    const Diagram& getDiagram() const;
 
-    VoronoiDiagram getDiagram();
+    // Delaunay triangulation, emitted during construct() only if enabled
+    // Triangle i is dual to vertex i of the diagram, until the diagram is intersected
+    void setTriangulationEnabled(bool enabled);
+    const std::vector<Index>& getTriangles() const; // Three sites per triangle, in counterclockwise order
+    const std::vector<Index>& getTriangleNeighbors() const; // Triangle opposite to each site, INVALID_INDEX on the hull
 
 private:
-    VoronoiDiagram mDiagram;
-    Beachline mBeachline;
-    PriorityQueue<Event> mEvents;
-    double mBeachlineY;
+    using Site = typename Diagram::Site;
+
+    Diagram mDiagram;
+    Beachline<T> mBeachline;
+    PriorityQueue<Event<T>> mEvents; // Only circle events
+    std::vector<Index> mSiteOrder;
+    std::vector<SortKey> mSortKeys;
+    std::vector<SortKey> mSortBuffer;
+    std::vector<std::size_t> mSortCounts;
+    double mBeachlineY; // Whatever the scalar type, as the breakpoints and the events
+    bool mIsTriangulationEnabled;
+    std::vector<Index> mTriangles;
+    std::vector<Index> mTriangleNeighbors;
+
+    // Edges still unbounded at the end of the construction, in left and right order
+    struct UnboundedEdge
+    {
+        Index leftSite;
+        Index rightSite;
+        Index leftHalfEdge; // Its origin is at infinity
+        Index rightHalfEdge; // Its destination is at infinity
+    };
+
+    std::vector<UnboundedEdge> mUnboundedEdges;
+    std::vector<UnboundedEdge> mTopEdges; // Between the highest sites, unbounded upward
 
     // Algorithm
-    void handleSiteEvent(Event* event);
-    void handleCircleEvent(Event* event);
+    void sortTiesByX(); // The equal-y runs of mSiteOrder, the sweep expects them from left to right
+    void sweep();
+    void handleSiteEvent(Site* site);
+    void handleCircleEvent(Event<T>* event);
 
     // Arcs
-    Arc* breakArc(Arc* arc, VoronoiDiagram::Site* site);
-    void removeArc(Arc* arc, VoronoiDiagram::Vertex* vertex);
-
-    // Breakpoint
-    bool isMovingRight(const Arc* left, const Arc* right) const;
-    double getInitialX(const Arc* left, const Arc* right, bool movingRight) const;
+    Arc<T>* breakArc(Arc<T>* arc, Site* site);
+    void removeArc(Arc<T>* arc, Index vertex);
 
     // Edges
-    void addEdge(Arc* left, Arc* right);
-    void setOrigin(Arc* left, Arc* right, VoronoiDiagram::Vertex* vertex);
-    void setDestination(Arc* left, Arc* right, VoronoiDiagram::Vertex* vertex);
-    void setPrevHalfEdge(VoronoiDiagram::HalfEdge* prev, VoronoiDiagram::HalfEdge* next);
+    void addEdge(Arc<T>* left, Arc<T>* right);
+    void setOrigin(Arc<T>* left, Arc<T>* right, Index vertex);
+    void setDestination(Arc<T>* left, Arc<T>* right, Index vertex);
+    void setPrevHalfEdge(Index prev, Index next);
+
+    // Triangulation
+    void addTriangle(const Arc<T>* left, const Arc<T>* middle, const Arc<T>* right);
+    void linkTriangles(Index triangle, int side, Index halfEdge);
 
     // Events
-    void addEvent(Arc* left, Arc* middle, Arc* right);
-    void deleteEvent(Arc* arc);
-    Vector2 computeConvergencePoint(const Vector2& point1, const Vector2& point2, const Vector2& point3, double& y) const;
+    void addEvent(Arc<T>* left, Arc<T>* middle, Arc<T>* right);
+    void addEvents(const std::array<Arc<T>*, 3>& leftTriplet, const std::array<Arc<T>*, 3>& rightTriplet);
+    void deleteEvent(Arc<T>* arc);
+
+    // Parallel construction
+
+    // Edge of a triangle whose neighbor belongs to another strip, triangles sides are numbered 3 * triangle + side
+    struct CrossEdge
+    {
+        std::uint64_t sites;
+        Index side;
+    };
+
+    struct Strip
+    {
+        std::unique_ptr<BasicFortuneAlgorithm> algorithm;
+        std::vector<Index> ranks; // Rank in x order of each local site
+        std::vector<Index> extraRanks; // Sites outside of the halo in the circumcircles of owned triangles
+        std::vector<Vector2> points;
+        std::vector<Index> ownedTriangles; // Index among the owned triangles of each local triangle
+        // Triangles owned by the strip, the sites are global and the neighbors are local to the strip
+        std::vector<Index> triangles;
+        std::vector<Index> neighbors;
+        std::vector<Vector2> vertices;
+        std::vector<CrossEdge> crossEdges;
+        std::vector<Index> hullSides;
+        std::size_t offset; // Index of the first owned triangle in the diagram
+    };
+
+    std::vector<Strip> mStrips;
+    std::vector<Vector2> mSortedPoints; // By increasing x
+    std::vector<std::array<T, 2>> mBlockYRanges; // Range of y of each block of sites in x order
+    std::vector<Index> mHullRanks;
+    std::vector<bool> mIsOnHull; // By rank
+    std::vector<CrossEdge> mCrossEdges;
+
+    void buildStrip(Strip& strip, std::size_t begin, std::size_t end, T haloWidth);
+    void addSitesInCircle(const Vector2& center, T squaredRadius, std::size_t begin, std::size_t end,
+        std::vector<Index>& ranks) const;
+    void computeHull();
+    bool mergeStrips(std::size_t nbThreads);
 
     // Bounding
 
+    void collectUnboundedEdges();
+
     struct LinkedVertex
     {
-        VoronoiDiagram::HalfEdge* prevHalfEdge;
-        VoronoiDiagram::Vertex* vertex;
-        VoronoiDiagram::HalfEdge* nextHalfEdge;
+        Index prevHalfEdge;
+        Index vertex;
+        Index nextHalfEdge;
     };
+
+    std::vector<LinkedVertex> mLinkedVertices;
+    std::vector<std::array<Index, 8>> mCellVertices; // Linked vertices on each side of each cell
+    std::vector<Index> mBorderSites;
 };
 
+using FortuneAlgorithm = BasicFortuneAlgorithm<double>;
+using FortuneAlgorithmf = BasicFortuneAlgorithm<float>;
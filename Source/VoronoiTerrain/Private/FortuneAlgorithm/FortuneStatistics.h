@@ -0,0 +1,78 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+// The statistics cost a few increments in the hot loops, they are compiled out unless FORTUNE_ENABLE_STATISTICS is 1
+#ifndef FORTUNE_ENABLE_STATISTICS
+    #define FORTUNE_ENABLE_STATISTICS 0
+#endif
+
+#if FORTUNE_ENABLE_STATISTICS
+    #define FORTUNE_STATISTICS(statement) statement
+#else
+    #define FORTUNE_STATISTICS(statement)
+#endif
+
+// Counters of a diagram since its last reset, filled by construct(), bound(), clip() and intersect()
+struct FortuneStatistics
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Events
+    std::size_t nbSiteEvents = 0;
+    std::size_t nbCircleEvents = 0; // Processed
+    std::size_t nbCreatedCircleEvents = 0;
+    std::size_t nbDeletedCircleEvents = 0; // False alarms removed by deleteEvent before being processed
+    // Beachline
+    std::size_t maxBeachlineSize = 0; // In arcs
+    std::size_t nbArcLocations = 0;
+    std::size_t totalArcLocationDepth = 0; // Nodes visited by locateArcAbove
+    std::size_t maxArcLocationDepth = 0;
+    // Diagram
+    std::size_t nbCreatedVertices = 0;
+    std::size_t nbRemovedVertices = 0;
+    std::size_t nbCreatedHalfEdges = 0;
+    std::size_t nbRemovedHalfEdges = 0;
+    // Wall time of each phase in ns, clip() counts the closing of the cells as bounding
+    double constructTime = 0.0;
+    double boundTime = 0.0;
+    double intersectTime = 0.0;
+
+    // Add the sweep counters of a diagram built separately
+    void addEvents(const FortuneStatistics& other)
+    {
+        nbSiteEvents += other.nbSiteEvents;
+        nbCircleEvents += other.nbCircleEvents;
+        nbCreatedCircleEvents += other.nbCreatedCircleEvents;
+        nbDeletedCircleEvents += other.nbDeletedCircleEvents;
+        maxBeachlineSize = std::max(maxBeachlineSize, other.maxBeachlineSize);
+        nbArcLocations += other.nbArcLocations;
+        totalArcLocationDepth += other.totalArcLocationDepth;
+        maxArcLocationDepth = std::max(maxArcLocationDepth, other.maxArcLocationDepth);
+    }
+
+    static double getElapsedTime(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+};
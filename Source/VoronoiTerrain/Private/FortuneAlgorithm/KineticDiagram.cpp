@@ -0,0 +1,730 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "KineticDiagram.h"
+// STL
+#include <algorithm>
+// My includes
+#include "Reserve.h"
+
+KineticDiagram::KineticDiagram() : mNbSites(0), mNbFlips(0)
+{
+
+}
+
+bool KineticDiagram::build(const FortuneAlgorithm& algorithm)
+{
+    constexpr Index NONE = VoronoiDiagram::INVALID_INDEX;
+    const VoronoiDiagram& diagram = algorithm.getDiagram();
+    std::size_t nbSites = diagram.getNbSites();
+    mNbSites = 0;
+    mPoints.resize(nbSites);
+    mWeights.clear();
+    for (std::size_t i = 0; i < nbSites; ++i)
+        mPoints[i] = diagram.getSite(i)->point;
+    mSiteTriangles.assign(nbSites + NB_GHOSTS, NONE);
+    mNbFlips = 0;
+    // The triangulation emitted by the algorithm has the same layout
+    const std::vector<Index>& triangles = algorithm.getTriangles();
+    const std::vector<Index>& neighbors = algorithm.getTriangleNeighbors();
+    mTriangles.resize(triangles.size() / 3);
+    for (Index t = 0; t < mTriangles.size(); ++t)
+    {
+        Triangle& triangle = mTriangles[t];
+        for (int k = 0; k < 3; ++k)
+        {
+            triangle.sites[k] = triangles[3 * t + k];
+            triangle.neighbors[k] = neighbors[3 * t + k];
+            mSiteTriangles[triangle.sites[k]] = t;
+        }
+    }
+    // Triangles missing from the sweep would leave holes that the flips cannot repair, the caller builds it again
+    if (mTriangles.empty() || !isTriangulationComplete())
+    {
+        mTriangles.clear();
+        return false;
+    }
+    mNbSites = nbSites;
+    insertGhosts();
+    if (!flipEdges())
+    {
+        mTriangles.clear();
+        return false;
+    }
+    computeCircumcenters();
+    return true;
+}
+
+bool KineticDiagram::build(std::span<const Vector2> points, std::span<const double> weights)
+{
+    constexpr Index NONE = VoronoiDiagram::INVALID_INDEX;
+    std::size_t nbSites = points.size();
+    mNbSites = 0;
+    mNbFlips = 0;
+    mTriangles.clear();
+    mFreeTriangles.clear();
+    if (nbSites == 0 || weights.size() != nbSites)
+        return false;
+    mPoints.assign(points.begin(), points.end());
+    mWeights.assign(weights.begin(), weights.end());
+    mSiteTriangles.assign(nbSites + NB_GHOSTS, NONE);
+    mHullTriangles.assign(nbSites + NB_GHOSTS, NONE);
+    // A triangulation of n sites has at most 2n - 5 triangles, the free ones are reused by the next insertions
+    reserveGeometrically(mTriangles, 2 * (nbSites + NB_GHOSTS));
+    reserveGeometrically(mCavityStamps, 2 * (nbSites + NB_GHOSTS));
+    // The ghosts start the triangulation with two triangles,
+    // they have the lowest weight so that their cells stay far from the sites
+    double ghostWeight = *std::min_element(weights.begin(), weights.end());
+    for (const Vector2& ghost : computeGhosts())
+    {
+        mPoints.push_back(ghost);
+        mWeights.push_back(ghostWeight);
+    }
+    Index g = static_cast<Index>(nbSites);
+    mTriangles.push_back(Triangle{{g, g + 1, g + 2}, {NONE, 1, NONE}, Vector2()});
+    mTriangles.push_back(Triangle{{g, g + 2, g + 3}, {NONE, NONE, 0}, Vector2()});
+    mSiteTriangles[g] = 0;
+    mSiteTriangles[g + 1] = 0;
+    mSiteTriangles[g + 2] = 0;
+    mSiteTriangles[g + 3] = 1;
+    mCavityStamps.assign(2, NONE);
+    // Insert the sites along a Morton curve so that the walk from the previous site is short
+    const Vector2& min = mPoints[g];
+    double scale = 65535.0 / (mPoints[g + 2].x - min.x);
+    auto spread = [](std::uint64_t x)
+    {
+        x = (x | (x << 8)) & 0x00FF00FF;
+        x = (x | (x << 4)) & 0x0F0F0F0F;
+        x = (x | (x << 2)) & 0x33333333;
+        return (x | (x << 1)) & 0x55555555;
+    };
+    mSortKeys.resize(nbSites);
+    for (Index i = 0; i < nbSites; ++i)
+    {
+        std::uint64_t x = static_cast<std::uint64_t>((mPoints[i].x - min.x) * scale);
+        std::uint64_t y = static_cast<std::uint64_t>((mPoints[i].y - min.y) * scale);
+        mSortKeys[i] = SortKey{spread(x) | (spread(y) << 1), i};
+    }
+    sortKeys(mSortKeys, mSortBuffer, mSortCounts);
+    Index hint = 0;
+    for (const SortKey& key : mSortKeys)
+    {
+        if (!insert(key.index, hint))
+        {
+            mTriangles.clear();
+            return false;
+        }
+    }
+    compactTriangles();
+    mNbSites = nbSites;
+    computeCircumcenters();
+    return true;
+}
+
+bool KineticDiagram::update(std::span<const Vector2> points)
+{
+    if (mTriangles.empty() || !mWeights.empty() || points.size() != mNbSites)
+        return false;
+    mStartPoints.assign(mPoints.begin(), mPoints.begin() + mNbSites);
+    mNbFlips = 0;
+    // The motion is split until the sites that crossed an edge during a step can be put back with a flip
+    double reached = 0.0;
+    double step = 1.0;
+    while (reached < 1.0)
+    {
+        double target = std::min(reached + step, 1.0);
+        movePoints(points, target);
+        if (!untangle())
+        {
+            step *= 0.5;
+            if (step < MIN_STEP)
+                return false;
+            continue;
+        }
+        // Check the certificates and repair
+        if (!flipEdges())
+            return false;
+        reached = target;
+        step = std::min(2.0 * step, 1.0);
+    }
+    computeCircumcenters();
+    return true;
+}
+
+bool KineticDiagram::isEmpty() const
+{
+    return mTriangles.empty();
+}
+
+std::size_t KineticDiagram::getNbSites() const
+{
+    return mNbSites;
+}
+
+std::size_t KineticDiagram::getNbTriangles() const
+{
+    return mTriangles.size();
+}
+
+std::size_t KineticDiagram::getNbFlips() const
+{
+    return mNbFlips;
+}
+
+void KineticDiagram::computeCell(std::size_t site, const Box& box, std::vector<Vector2>& cell)
+{
+    constexpr Index NONE = VoronoiDiagram::INVALID_INDEX;
+    cell.clear();
+    Index start = mSiteTriangles[site];
+    if (start == NONE)
+        return;
+    auto getSlot = [this, site](Index t)
+    {
+        const std::array<Index, 3>& sites = mTriangles[t].sites;
+        return sites[0] == site ? 0 : (sites[1] == site ? 1 : 2);
+    };
+    // The sites are inside the hull, the circumcenters around a site are the vertices of its cell
+    Index t = start;
+    do
+    {
+        cell.push_back(mTriangles[t].circumcenter);
+        t = mTriangles[t].neighbors[(getSlot(t) + 1) % 3];
+    } while (t != NONE && t != start);
+    if (t == NONE)
+    {
+        cell.clear();
+        return;
+    }
+    // Clip with each side of the box
+    auto clip = [this, &cell](auto isInside, auto intersect)
+    {
+        mClipBuffer.clear();
+        for (std::size_t i = 0; i < cell.size(); ++i)
+        {
+            const Vector2& current = cell[i];
+            const Vector2& next = cell[(i + 1) % cell.size()];
+            if (isInside(current))
+                mClipBuffer.push_back(current);
+            if (isInside(current) != isInside(next))
+                mClipBuffer.push_back(intersect(current, next));
+        }
+        cell.swap(mClipBuffer);
+    };
+    auto intersectX = [](double x)
+    {
+        return [x](const Vector2& p, const Vector2& q) { return p + ((x - p.x) / (q.x - p.x)) * (q - p); };
+    };
+    auto intersectY = [](double y)
+    {
+        return [y](const Vector2& p, const Vector2& q) { return p + ((y - p.y) / (q.y - p.y)) * (q - p); };
+    };
+    clip([&box](const Vector2& p) { return p.x >= box.left; }, intersectX(box.left));
+    clip([&box](const Vector2& p) { return p.x <= box.right; }, intersectX(box.right));
+    clip([&box](const Vector2& p) { return p.y >= box.bottom; }, intersectY(box.bottom));
+    clip([&box](const Vector2& p) { return p.y <= box.top; }, intersectY(box.top));
+}
+
+void KineticDiagram::exportCells(const Box& box, VoronoiDiagram::Cells& cells)
+{
+    cells.offsets.resize(mNbSites + 1);
+    cells.points.clear();
+    cells.vertices.clear();
+    // Each circumcenter is a corner of the cells of the three sites of its triangle, some more are added by the box
+    reserveGeometrically(cells.points, 3 * mTriangles.size());
+    for (std::size_t i = 0; i < mNbSites; ++i)
+    {
+        cells.offsets[i] = static_cast<Index>(cells.points.size());
+        computeCell(i, box, mCell);
+        cells.points.insert(cells.points.end(), mCell.begin(), mCell.end());
+    }
+    cells.offsets.back() = static_cast<Index>(cells.points.size());
+}
+
+bool KineticDiagram::isTriangulationComplete()
+{
+    constexpr Index NONE = VoronoiDiagram::INVALID_INDEX;
+    std::size_t nbSites = mPoints.size();
+    // The next site along the hull, counterclockwise
+    mHullTriangles.assign(nbSites, NONE);
+    std::size_t nbHullEdges = 0;
+    for (Index t = 0; t < mTriangles.size(); ++t)
+    {
+        const Triangle& triangle = mTriangles[t];
+        for (int k = 0; k < 3; ++k)
+        {
+            Index a = triangle.sites[(k + 1) % 3];
+            Index b = triangle.sites[(k + 2) % 3];
+            if (a >= nbSites || b >= nbSites)
+                return false;
+            Index u = triangle.neighbors[k];
+            if (u == NONE)
+            {
+                if (mHullTriangles[a] != NONE)
+                    return false;
+                mHullTriangles[a] = b;
+                ++nbHullEdges;
+                continue;
+            }
+            // The neighbor must see the same edge from the other side
+            if (u >= mTriangles.size())
+                return false;
+            const Triangle& other = mTriangles[u];
+            int side = other.neighbors[0] == t ? 0 : (other.neighbors[1] == t ? 1 : 2);
+            if (other.neighbors[side] != t || other.sites[(side + 1) % 3] != b || other.sites[(side + 2) % 3] != a)
+                return false;
+        }
+    }
+    // The boundary must be a single convex cycle, the holes left by missing triangles open on it and make it turn right,
+    // the collinear sites of the hull are within the rounding of the orientation
+    Index start = static_cast<Index>(std::find_if(mHullTriangles.begin(), mHullTriangles.end(),
+        [](Index next){ return next != NONE; }) - mHullTriangles.begin());
+    if (start == nbSites)
+        return false;
+    Index a = start;
+    Index b = mHullTriangles[a];
+    std::size_t nbSteps = 0;
+    do
+    {
+        Index c = mHullTriangles[b];
+        if (c == NONE)
+            return false;
+        double tolerance = 1e-9 * (mPoints[b] - mPoints[a]).getNorm() * (mPoints[c] - mPoints[b]).getNorm();
+        if (getOrientation(a, b, c) < -tolerance)
+            return false;
+        a = b;
+        b = c;
+        ++nbSteps;
+    } while (a != start && nbSteps <= nbHullEdges);
+    if (a != start || nbSteps != nbHullEdges)
+        return false;
+    // Euler's formula for a triangulation of n sites whose hull has h vertices, the sites without triangle are duplicates
+    std::size_t nbUsedSites = nbSites - static_cast<std::size_t>(std::count(mSiteTriangles.begin(), mSiteTriangles.begin() + nbSites, NONE));
+    return mTriangles.size() + 2 + nbHullEdges == 2 * nbUsedSites;
+}
+
+std::array<Vector2, KineticDiagram::NB_GHOSTS> KineticDiagram::computeGhosts() const
+{
+    // Far static sites around the sites, in counterclockwise order
+    Box bounds{mPoints[0].x, mPoints[0].y, mPoints[0].x, mPoints[0].y};
+    for (const Vector2& point : mPoints)
+    {
+        bounds.left = std::min(bounds.left, point.x);
+        bounds.bottom = std::min(bounds.bottom, point.y);
+        bounds.right = std::max(bounds.right, point.x);
+        bounds.top = std::max(bounds.top, point.y);
+    }
+    Vector2 center(0.5 * (bounds.left + bounds.right), 0.5 * (bounds.bottom + bounds.top));
+    double distance = GHOST_DISTANCE * std::max(std::max(bounds.right - bounds.left, bounds.top - bounds.bottom), 1.0);
+    return {
+        center + Vector2(-distance, -distance),
+        center + Vector2(distance, -distance),
+        center + Vector2(distance, distance),
+        center + Vector2(-distance, distance)};
+}
+
+void KineticDiagram::insertGhosts()
+{
+    // The hull of the triangulation is then fixed
+    constexpr Index NONE = VoronoiDiagram::INVALID_INDEX;
+    for (const Vector2& ghost : computeGhosts())
+    {
+        Index g = static_cast<Index>(mPoints.size());
+        mPoints.push_back(ghost);
+        // Cover each hull edge ab visible from the ghost with a triangle bag
+        mHullTriangles.assign(mPoints.size(), NONE);
+        std::size_t nbTriangles = mTriangles.size();
+        for (Index t = 0; t < nbTriangles; ++t)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                Index a = mTriangles[t].sites[(k + 1) % 3];
+                Index b = mTriangles[t].sites[(k + 2) % 3];
+                if (mTriangles[t].neighbors[k] != NONE || getOrientation(a, b, g) >= 0.0)
+                    continue;
+                Index u = static_cast<Index>(mTriangles.size());
+                mTriangles.push_back(Triangle{{b, a, g}, {NONE, NONE, t}, Vector2()});
+                mTriangles[t].neighbors[k] = u;
+                mHullTriangles[a] = u;
+                mSiteTriangles[g] = u;
+            }
+        }
+        // Link the new triangles sharing an edge with the ghost
+        for (Index u = static_cast<Index>(nbTriangles); u < mTriangles.size(); ++u)
+        {
+            Index next = mHullTriangles[mTriangles[u].sites[0]];
+            if (next != NONE)
+            {
+                mTriangles[u].neighbors[1] = next;
+                mTriangles[next].neighbors[0] = u;
+            }
+        }
+    }
+}
+
+bool KineticDiagram::insert(Index site, Index& hint)
+{
+    constexpr Index NONE = VoronoiDiagram::INVALID_INDEX;
+    Index start = locate(site, hint);
+    if (start == NONE)
+        return false;
+    // The site is redundant if it is not in conflict with the triangle containing it, its cell is then empty
+    auto isInConflict = [this, site](Index t)
+    {
+        const std::array<Index, 3>& sites = mTriangles[t].sites;
+        return getIncircle(sites[0], sites[1], sites[2], site) > 0.0;
+    };
+    hint = start;
+    if (!isInConflict(start))
+        return true;
+    // The triangles in conflict form a cavity star-shaped from the site
+    mCavity.clear();
+    mCavity.push_back(start);
+    mCavityStamps[start] = site;
+    for (std::size_t i = 0; i < mCavity.size(); ++i)
+    {
+        for (Index u : mTriangles[mCavity[i]].neighbors)
+        {
+            if (u != NONE && mCavityStamps[u] != site && isInConflict(u))
+            {
+                mCavityStamps[u] = site;
+                mCavity.push_back(u);
+            }
+        }
+    }
+    mCavityEdges.clear();
+    for (Index t : mCavity)
+    {
+        const Triangle& triangle = mTriangles[t];
+        for (int k = 0; k < 3; ++k)
+        {
+            Index u = triangle.neighbors[k];
+            if (u != NONE && mCavityStamps[u] == site)
+                continue;
+            Index a = triangle.sites[(k + 1) % 3];
+            Index b = triangle.sites[(k + 2) % 3];
+            if (getOrientation(a, b, site) <= 0.0)
+                return false;
+            // The boundary of the cavity must be a single cycle around the site
+            if (mHullTriangles[a] != NONE)
+                return false;
+            mHullTriangles[a] = t;
+            int side = u == NONE ? 0 : (mTriangles[u].neighbors[0] == t ? 0 : (mTriangles[u].neighbors[1] == t ? 1 : 2));
+            mCavityEdges.push_back(CavityEdge{a, b, u, side});
+        }
+    }
+    for (const CavityEdge& edge : mCavityEdges)
+        mHullTriangles[edge.a] = NONE;
+    // The sites inside the cavity are removed, the others get one of the new triangles
+    for (Index t : mCavity)
+    {
+        for (Index s : mTriangles[t].sites)
+            mSiteTriangles[s] = NONE;
+        mFreeTriangles.push_back(t);
+    }
+    // Fan the cavity from the site
+    for (const CavityEdge& edge : mCavityEdges)
+    {
+        Index t;
+        if (!mFreeTriangles.empty())
+        {
+            t = mFreeTriangles.back();
+            mFreeTriangles.pop_back();
+            mTriangles[t] = Triangle{{edge.a, edge.b, site}, {NONE, NONE, edge.outside}, Vector2()};
+        }
+        else
+        {
+            t = static_cast<Index>(mTriangles.size());
+            mTriangles.push_back(Triangle{{edge.a, edge.b, site}, {NONE, NONE, edge.outside}, Vector2()});
+            mCavityStamps.push_back(NONE);
+        }
+        if (edge.outside != NONE)
+            mTriangles[edge.outside].neighbors[edge.side] = t;
+        mHullTriangles[edge.a] = t;
+        mSiteTriangles[edge.a] = t;
+    }
+    for (const CavityEdge& edge : mCavityEdges)
+    {
+        Index t = mHullTriangles[edge.a];
+        Index next = mHullTriangles[edge.b];
+        mTriangles[t].neighbors[0] = next;
+        mTriangles[next].neighbors[1] = t;
+    }
+    for (const CavityEdge& edge : mCavityEdges)
+        mHullTriangles[edge.a] = NONE;
+    // The unused triangles stay free until the next insertions
+    for (Index t : mFreeTriangles)
+        mTriangles[t].sites[0] = NONE;
+    hint = mSiteTriangles[mCavityEdges.front().a];
+    mSiteTriangles[site] = hint;
+    // The ghosts must keep their cells to close the hull
+    for (std::size_t g = mSiteTriangles.size() - NB_GHOSTS; g < mSiteTriangles.size(); ++g)
+    {
+        if (mSiteTriangles[g] == NONE)
+            return false;
+    }
+    return true;
+}
+
+KineticDiagram::Index KineticDiagram::locate(Index site, Index start) const
+{
+    // Walk toward the site until it is on the left of the three edges, the ghosts enclose all the sites
+    constexpr Index NONE = VoronoiDiagram::INVALID_INDEX;
+    Index t = start;
+    for (std::size_t i = 0; i < mTriangles.size(); ++i)
+    {
+        const Triangle& triangle = mTriangles[t];
+        int k = 0;
+        while (k < 3 && getOrientation(triangle.sites[(k + 1) % 3], triangle.sites[(k + 2) % 3], site) >= 0.0)
+            ++k;
+        if (k == 3)
+            return t;
+        t = triangle.neighbors[k];
+        if (t == NONE)
+            return NONE;
+    }
+    return NONE;
+}
+
+void KineticDiagram::compactTriangles()
+{
+    // Move the triangles over the free ones, mCavityStamps is reused to store the new indices
+    constexpr Index NONE = VoronoiDiagram::INVALID_INDEX;
+    if (mFreeTriangles.empty())
+        return;
+    Index nbTriangles = 0;
+    for (Index t = 0; t < mTriangles.size(); ++t)
+    {
+        if (mTriangles[t].sites[0] == NONE)
+            continue;
+        mCavityStamps[t] = nbTriangles;
+        mTriangles[nbTriangles++] = mTriangles[t];
+    }
+    mTriangles.resize(nbTriangles);
+    for (Triangle& triangle : mTriangles)
+    {
+        for (Index& neighbor : triangle.neighbors)
+        {
+            if (neighbor != NONE)
+                neighbor = mCavityStamps[neighbor];
+        }
+    }
+    for (Index& triangle : mSiteTriangles)
+    {
+        if (triangle != NONE)
+            triangle = mCavityStamps[triangle];
+    }
+    mFreeTriangles.clear();
+}
+
+bool KineticDiagram::flipEdges()
+{
+    // Check the certificates of all the interior edges, and the edges around each flip
+    constexpr Index NONE = VoronoiDiagram::INVALID_INDEX;
+    mEdgesToCheck.clear();
+    // Half of the sides of the triangles, and some room for the edges around the flips
+    reserveGeometrically(mEdgesToCheck, 2 * mTriangles.size());
+    for (Index t = 0; t < mTriangles.size(); ++t)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            if (mTriangles[t].neighbors[k] != NONE && mTriangles[t].neighbors[k] > t)
+                mEdgesToCheck.push_back(Edge{t, k});
+        }
+    }
+    std::size_t maxNbFlips = 4 * mTriangles.size() + 16;
+    std::size_t nbFlips = 0;
+    while (!mEdgesToCheck.empty())
+    {
+        Edge edge = mEdgesToCheck.back();
+        mEdgesToCheck.pop_back();
+        const Triangle& triangle = mTriangles[edge.triangle];
+        Index u = triangle.neighbors[edge.side];
+        if (u == NONE)
+            continue;
+        const Triangle& neighbor = mTriangles[u];
+        int m = neighbor.neighbors[0] == edge.triangle ? 0 : (neighbor.neighbors[1] == edge.triangle ? 1 : 2);
+        Index a = triangle.sites[edge.side];
+        Index b = triangle.sites[(edge.side + 1) % 3];
+        Index c = triangle.sites[(edge.side + 2) % 3];
+        Index d = neighbor.sites[m];
+        // The certificate fails if d is in the circumcircle of abc, the quadrilateral abdc must be convex to flip
+        if (getIncircle(a, b, c, d) > 0.0 && getOrientation(a, b, d) > 0.0 && getOrientation(a, d, c) > 0.0)
+        {
+            flip(edge.triangle, edge.side);
+            if (++nbFlips > maxNbFlips)
+                return false;
+        }
+    }
+    mNbFlips += nbFlips;
+    return true;
+}
+
+void KineticDiagram::flip(Index t, int k)
+{
+    // abc and dcb become abd and adc
+    Triangle& triangle = mTriangles[t];
+    Index u = triangle.neighbors[k];
+    Triangle& neighbor = mTriangles[u];
+    int m = neighbor.neighbors[0] == t ? 0 : (neighbor.neighbors[1] == t ? 1 : 2);
+    Index a = triangle.sites[k];
+    Index b = triangle.sites[(k + 1) % 3];
+    Index c = triangle.sites[(k + 2) % 3];
+    Index d = neighbor.sites[m];
+    Index ab = triangle.neighbors[(k + 2) % 3];
+    Index ca = triangle.neighbors[(k + 1) % 3];
+    Index bd = neighbor.neighbors[(m + 1) % 3];
+    Index dc = neighbor.neighbors[(m + 2) % 3];
+    triangle.sites = {a, b, d};
+    triangle.neighbors = {bd, u, ab};
+    neighbor.sites = {a, d, c};
+    neighbor.neighbors = {dc, ca, t};
+    replaceNeighbor(bd, u, t);
+    replaceNeighbor(ca, t, u);
+    mSiteTriangles[a] = t;
+    mSiteTriangles[b] = t;
+    mSiteTriangles[d] = t;
+    mSiteTriangles[c] = u;
+    // The four edges of the quadrilateral must be checked again
+    mEdgesToCheck.push_back(Edge{t, 0});
+    mEdgesToCheck.push_back(Edge{t, 2});
+    mEdgesToCheck.push_back(Edge{u, 0});
+    mEdgesToCheck.push_back(Edge{u, 1});
+}
+
+void KineticDiagram::movePoints(std::span<const Vector2> points, double t)
+{
+    // The ghosts do not move
+    if (t >= 1.0)
+        std::copy(points.begin(), points.end(), mPoints.begin());
+    else
+    {
+        for (std::size_t i = 0; i < points.size(); ++i)
+            mPoints[i] = mStartPoints[i] + t * (points[i] - mStartPoints[i]);
+    }
+}
+
+bool KineticDiagram::untangle()
+{
+    // The site of an inverted triangle crossed the opposite edge, flipping it gives two valid triangles
+    constexpr Index NONE = VoronoiDiagram::INVALID_INDEX;
+    mInvertedTriangles.clear();
+    for (Index t = 0; t < mTriangles.size(); ++t)
+    {
+        if (isInverted(t))
+            mInvertedTriangles.push_back(t);
+    }
+    std::size_t maxNbFlips = 4 * mInvertedTriangles.size();
+    std::size_t nbFlips = 0;
+    while (!mInvertedTriangles.empty())
+    {
+        Index t = mInvertedTriangles.back();
+        mInvertedTriangles.pop_back();
+        if (!isInverted(t))
+            continue;
+        const Triangle& triangle = mTriangles[t];
+        bool isFlipped = false;
+        for (int k = 0; k < 3 && !isFlipped; ++k)
+        {
+            Index u = triangle.neighbors[k];
+            if (u == NONE)
+                continue;
+            const Triangle& neighbor = mTriangles[u];
+            int m = neighbor.neighbors[0] == t ? 0 : (neighbor.neighbors[1] == t ? 1 : 2);
+            Index a = triangle.sites[k];
+            Index b = triangle.sites[(k + 1) % 3];
+            Index c = triangle.sites[(k + 2) % 3];
+            Index d = neighbor.sites[m];
+            // a must be inside the neighbor, and b and c must keep two triangles each
+            bool isInside = getOrientation(a, b, d) > 0.0 && getOrientation(a, d, c) > 0.0;
+            bool isDegenerate = triangle.neighbors[(k + 2) % 3] == neighbor.neighbors[(m + 1) % 3] ||
+                triangle.neighbors[(k + 1) % 3] == neighbor.neighbors[(m + 2) % 3];
+            if (isInside && !isDegenerate)
+            {
+                flip(t, k);
+                isFlipped = true;
+                if (isInverted(u))
+                    mInvertedTriangles.push_back(u);
+            }
+        }
+        if (!isFlipped || ++nbFlips > maxNbFlips)
+            return false;
+    }
+    mNbFlips += nbFlips;
+    return true;
+}
+
+bool KineticDiagram::isInverted(Index t) const
+{
+    const Triangle& triangle = mTriangles[t];
+    return getOrientation(triangle.sites[0], triangle.sites[1], triangle.sites[2]) <= 0.0;
+}
+
+void KineticDiagram::replaceNeighbor(Index triangle, Index oldNeighbor, Index newNeighbor)
+{
+    if (triangle == VoronoiDiagram::INVALID_INDEX)
+        return;
+    for (Index& neighbor : mTriangles[triangle].neighbors)
+    {
+        if (neighbor == oldNeighbor)
+            neighbor = newNeighbor;
+    }
+}
+
+void KineticDiagram::computeCircumcenters()
+{
+    for (Triangle& triangle : mTriangles)
+    {
+        const Vector2& a = mPoints[triangle.sites[0]];
+        Vector2 b = mPoints[triangle.sites[1]] - a;
+        Vector2 c = mPoints[triangle.sites[2]] - a;
+        double d = 2.0 * b.getDet(c);
+        double b2 = b.dot(b);
+        double c2 = c.dot(c);
+        // With weights, the center has the same power with respect to the three sites
+        if (!mWeights.empty())
+        {
+            double weight = mWeights[triangle.sites[0]];
+            b2 -= mWeights[triangle.sites[1]] - weight;
+            c2 -= mWeights[triangle.sites[2]] - weight;
+        }
+        triangle.circumcenter = a + Vector2((c.y * b2 - b.y * c2) / d, (b.x * c2 - c.x * b2) / d);
+    }
+}
+
+double KineticDiagram::getOrientation(Index a, Index b, Index c) const
+{
+    return (mPoints[b] - mPoints[a]).getDet(mPoints[c] - mPoints[a]);
+}
+
+double KineticDiagram::getIncircle(Index a, Index b, Index c, Index d) const
+{
+    // Positive if d is inside the circumcircle of the counterclockwise triangle abc,
+    // with weights the heights of the sites lifted on the paraboloid are lowered by their weights
+    Vector2 ad = mPoints[a] - mPoints[d];
+    Vector2 bd = mPoints[b] - mPoints[d];
+    Vector2 cd = mPoints[c] - mPoints[d];
+    double ah = ad.dot(ad);
+    double bh = bd.dot(bd);
+    double ch = cd.dot(cd);
+    if (!mWeights.empty())
+    {
+        ah -= mWeights[a] - mWeights[d];
+        bh -= mWeights[b] - mWeights[d];
+        ch -= mWeights[c] - mWeights[d];
+    }
+    return ah * bd.getDet(cd) - bh * ad.getDet(cd) + ch * ad.getDet(bd);
+}
@@ -0,0 +1,129 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// STL
+#include <array>
+#include <span>
+#include <vector>
+// My includes
+#include "FortuneAlgorithm.h"
+
+// Delaunay triangulation dual to a Voronoi diagram whose sites move slowly.
+// The topology is kept between updates: the Voronoi vertices are recomputed as the circumcenters of their three
+// sites, and only the edges whose certificate fails (the opposite site entered the circumcircle) are flipped.
+// Four static ghost sites far around the sites close the hull, so the hull never has to be repaired.
+// With a weight per site, the triangulation is the regular one and its dual is the power diagram.
+class KineticDiagram
+{
+public:
+    KineticDiagram();
+
+    // Build from the triangulation emitted by FortuneAlgorithm, it must be enabled before construct(), false if it is
+    // incomplete and the diagram is left empty
+    bool build(const FortuneAlgorithm& algorithm);
+    // Build the regular triangulation of weighted sites by incremental insertion, its dual is the power diagram:
+    // the cell of a site grows with its weight and is empty if the other cells cover it
+    bool build(std::span<const Vector2> points, std::span<const double> weights);
+    // Move the sites and repair the triangulation locally, return false if the diagram must be built again
+    // Weighted diagrams are always built again as sites may have to be removed or added back
+    bool update(std::span<const Vector2> points);
+
+    // Accessors
+    bool isEmpty() const;
+    std::size_t getNbSites() const;
+    std::size_t getNbTriangles() const;
+    std::size_t getNbFlips() const; // During the last update
+
+    // Cell of a site clipped to a box around the sites, in counterclockwise order
+    void computeCell(std::size_t site, const Box& box, std::vector<Vector2>& cell);
+    // Cells of all the sites in the format of VoronoiDiagram::exportCells, without the vertex indices
+    void exportCells(const Box& box, VoronoiDiagram::Cells& cells);
+
+private:
+    using Index = VoronoiDiagram::Index;
+
+    static constexpr std::size_t NB_GHOSTS = 4;
+    static constexpr double GHOST_DISTANCE = 16.0; // Relatively to the extent of the sites
+    static constexpr double MIN_STEP = 1.0 / 64.0;
+
+    // Sites in counterclockwise order, neighbors[k] is the triangle on the other side of the edge opposite to sites[k]
+    struct Triangle
+    {
+        std::array<Index, 3> sites;
+        std::array<Index, 3> neighbors;
+        Vector2 circumcenter;
+    };
+
+    struct Edge
+    {
+        Index triangle;
+        int side;
+    };
+
+    std::size_t mNbSites;
+    std::vector<Vector2> mPoints; // The sites followed by the ghosts
+    std::vector<double> mWeights; // Empty if the diagram is not weighted
+    std::vector<Triangle> mTriangles;
+    std::vector<Index> mSiteTriangles; // One triangle incident to each site, INVALID_INDEX if its cell is empty
+    std::size_t mNbFlips;
+    // Scratch buffers
+    std::vector<Vector2> mStartPoints;
+    std::vector<Edge> mEdgesToCheck;
+    std::vector<Index> mInvertedTriangles;
+    std::vector<Index> mHullTriangles; // Indexed by the first site of the edge
+    std::vector<Vector2> mClipBuffer;
+    std::vector<Vector2> mCell;
+    std::vector<SortKey> mSortKeys;
+    std::vector<SortKey> mSortBuffer;
+    std::vector<std::size_t> mSortCounts;
+    std::vector<Index> mCavity;
+    std::vector<Index> mCavityStamps; // Last site whose cavity contained each triangle
+    std::vector<Index> mFreeTriangles;
+
+    struct CavityEdge
+    {
+        Index a;
+        Index b;
+        Index outside;
+        int side; // Of the edge in the outside triangle
+    };
+
+    std::vector<CavityEdge> mCavityEdges;
+
+    // Build
+    bool isTriangulationComplete(); // Of the triangles copied from the sweep, the neighbors must be symmetric and none missing
+    std::array<Vector2, NB_GHOSTS> computeGhosts() const;
+    void insertGhosts();
+    bool insert(Index site, Index& hint);
+    Index locate(Index site, Index start) const;
+    void compactTriangles();
+
+    // Repairs
+    void movePoints(std::span<const Vector2> points, double t);
+    bool untangle();
+    bool isInverted(Index t) const;
+    bool flipEdges();
+    void flip(Index t, int k);
+    void replaceNeighbor(Index triangle, Index oldNeighbor, Index newNeighbor);
+    void computeCircumcenters();
+
+    // Predicates
+    double getOrientation(Index a, Index b, Index c) const;
+    double getIncircle(Index a, Index b, Index c, Index d) const;
+};
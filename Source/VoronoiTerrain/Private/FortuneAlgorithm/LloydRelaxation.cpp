@@ -0,0 +1,124 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LloydRelaxation.h"
+// STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+// My includes
+#include "Parallel.h"
+
+namespace
+{
+    constexpr std::size_t SITES_PER_THREAD = 1 << 14; // Minimum number of sites for an additional thread
+    constexpr std::size_t MAX_NB_THREADS = 16;
+
+    std::size_t getNbThreads(std::size_t size)
+    {
+        std::size_t nbThreads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+        return std::max<std::size_t>(std::min({nbThreads, MAX_NB_THREADS, size / SITES_PER_THREAD}), 1);
+    }
+}
+
+LloydRelaxation::LloydRelaxation() : mMaxDisplacement(std::numeric_limits<double>::infinity()), mNbIterations(0)
+{
+
+}
+
+bool LloydRelaxation::step(std::span<Vector2> points, const Box& box)
+{
+    mMaxDisplacement = std::numeric_limits<double>::infinity();
+    if (points.empty())
+        return false;
+    mAlgorithm.reset(points);
+    mAlgorithm.construct();
+    if (!mAlgorithm.clip(box))
+        return false;
+    mAlgorithm.getDiagram().exportCells(mCells);
+    // The cells are independent, each thread moves a range of sites and keeps its largest displacement
+    std::size_t nbThreads = getNbThreads(points.size());
+    mThreadDisplacements.assign(nbThreads, 0.0);
+    parallelFor(nbThreads, points.size(), [&](std::size_t thread, std::size_t begin, std::size_t end)
+    {
+        double maxSquaredDisplacement = 0.0;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            std::size_t first = mCells.offsets[i];
+            std::size_t last = mCells.offsets[i + 1];
+            if (last - first < 3)
+                continue;
+            // Relatively to the site to keep the precision on cells far from the origin
+            Vector2 site = points[i];
+            double area = 0.0;
+            Vector2 centroid;
+            for (std::size_t j = first; j < last; ++j)
+            {
+                Vector2 origin = mCells.points[j] - site;
+                Vector2 destination = mCells.points[j + 1 < last ? j + 1 : first] - site;
+                double value = origin.getDet(destination);
+                area += value;
+                centroid += value * (origin + destination);
+            }
+            // Degenerate cell, the site is left in place
+            if (!(area > 0.0))
+                continue;
+            Vector2 displacement = (1.0 / (3.0 * area)) * centroid;
+            points[i] = site + displacement;
+            maxSquaredDisplacement = std::max(maxSquaredDisplacement, displacement.x * displacement.x +
+                displacement.y * displacement.y);
+        }
+        mThreadDisplacements[thread] = maxSquaredDisplacement;
+    });
+    mMaxDisplacement = std::sqrt(*std::max_element(mThreadDisplacements.begin(), mThreadDisplacements.end()));
+    return true;
+}
+
+bool LloydRelaxation::relax(std::span<Vector2> points, const Box& box, std::size_t nbIterations, double tolerance)
+{
+    mNbIterations = 0;
+    while (mNbIterations < nbIterations)
+    {
+        if (!step(points, box))
+            return false;
+        ++mNbIterations;
+        if (hasConverged(tolerance))
+            break;
+    }
+    return true;
+}
+
+double LloydRelaxation::getMaxDisplacement() const
+{
+    return mMaxDisplacement;
+}
+
+std::size_t LloydRelaxation::getNbIterations() const
+{
+    return mNbIterations;
+}
+
+bool LloydRelaxation::hasConverged(double tolerance) const
+{
+    return mMaxDisplacement < tolerance;
+}
+
+const VoronoiDiagram::Cells& LloydRelaxation::getCells() const
+{
+    return mCells;
+}
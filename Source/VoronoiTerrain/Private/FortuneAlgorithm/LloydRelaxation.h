@@ -0,0 +1,52 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// STL
+#include <span>
+#include <vector>
+// My includes
+#include "FortuneAlgorithm.h"
+
+// Lloyd's algorithm: each iteration builds the diagram of the sites clipped to a box and moves every site to
+// the centroid of its cell, the sites converge to a centroidal Voronoi tessellation.
+// The buffers are kept between iterations and between calls, so that one step per frame does not allocate.
+class LloydRelaxation
+{
+public:
+    LloydRelaxation();
+
+    // Move the sites to the centroids of their cells once, return false if the diagram could not be built
+    bool step(std::span<Vector2> points, const Box& box);
+    // Iterate until the maximum displacement is below tolerance or after nbIterations, return false on failure
+    bool relax(std::span<Vector2> points, const Box& box, std::size_t nbIterations, double tolerance);
+
+    // Accessors
+    double getMaxDisplacement() const; // During the last iteration
+    std::size_t getNbIterations() const; // During the last call to relax
+    bool hasConverged(double tolerance) const;
+    // Cells of the sites before the last iteration
+    const VoronoiDiagram::Cells& getCells() const;
+
+private:
+    FortuneAlgorithm mAlgorithm;
+    VoronoiDiagram::Cells mCells;
+    std::vector<double> mThreadDisplacements;
+    double mMaxDisplacement;
+    std::size_t mNbIterations;
+};
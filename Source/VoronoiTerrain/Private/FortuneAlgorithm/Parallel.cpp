@@ -0,0 +1,80 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Parallel.h"
+
+WorkerPool& WorkerPool::get()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+    }
+    mStartCondition.notify_all();
+    for (std::thread& thread : mThreads)
+        thread.join();
+}
+
+bool WorkerPool::run(std::size_t nbThreads, Job job, const void* context)
+{
+    if (mIsBusy.exchange(true, std::memory_order_acquire))
+        return false;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        // The new workers wait for the next generation, which is this job
+        while (mThreads.size() + 1 < nbThreads)
+            mThreads.emplace_back(&WorkerPool::work, this, mThreads.size() + 1, mGeneration);
+        mJob = job;
+        mContext = context;
+        mNbThreads = nbThreads;
+        mNbPendingThreads = nbThreads - 1;
+        ++mGeneration;
+    }
+    mStartCondition.notify_all();
+    job(context, 0);
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDoneCondition.wait(lock, [this]{ return mNbPendingThreads == 0; });
+    }
+    mIsBusy.store(false, std::memory_order_release);
+    return true;
+}
+
+void WorkerPool::work(std::size_t thread, std::uint64_t generation)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true)
+    {
+        mStartCondition.wait(lock, [&]{ return mIsStopping || mGeneration != generation; });
+        if (mIsStopping)
+            return;
+        generation = mGeneration;
+        // The jobs with fewer threads leave the last workers idle
+        if (thread >= mNbThreads)
+            continue;
+        lock.unlock();
+        mJob(mContext, thread);
+        lock.lock();
+        if (--mNbPendingThreads == 0)
+            mDoneCondition.notify_one();
+    }
+}
@@ -0,0 +1,80 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads kept between the calls of parallelFor, they are started the first time they are needed so that the
+// later calls do not allocate
+class WorkerPool
+{
+public:
+    using Job = void (*)(const void* context, std::size_t thread);
+
+    static WorkerPool& get();
+
+    ~WorkerPool();
+
+    // Call job(context, thread) for each thread in [0, nbThreads), the calling thread runs the first one.
+    // Return false without calling job if the workers are busy with another call, the caller then runs the job alone.
+    bool run(std::size_t nbThreads, Job job, const void* context);
+
+private:
+    WorkerPool() = default;
+
+    void work(std::size_t thread, std::uint64_t generation);
+
+    std::atomic<bool> mIsBusy{false}; // One call at a time, the nested calls are run by their caller
+    std::mutex mMutex;
+    std::condition_variable mStartCondition;
+    std::condition_variable mDoneCondition;
+    std::vector<std::thread> mThreads; // mThreads[i] runs thread i + 1
+    std::uint64_t mGeneration = 0; // Incremented for each job
+    Job mJob = nullptr;
+    const void* mContext = nullptr;
+    std::size_t mNbThreads = 0;
+    std::size_t mNbPendingThreads = 0;
+    bool mIsStopping = false;
+};
+
+// Call f(thread, begin, end) on nbThreads contiguous ranges covering [0, size), the calling thread runs the first one
+template<typename F>
+void parallelFor(std::size_t nbThreads, std::size_t size, const F& f)
+{
+    std::size_t chunkSize = (size + nbThreads - 1) / nbThreads;
+    auto run = [&](std::size_t thread)
+    {
+        f(thread, std::min(thread * chunkSize, size), std::min((thread + 1) * chunkSize, size));
+    };
+    using Run = decltype(run);
+    auto job = [](const void* context, std::size_t thread)
+    {
+        (*static_cast<const Run*>(context))(thread);
+    };
+    if (nbThreads > 1 && WorkerPool::get().run(nbThreads, job, &run))
+        return;
+    for (std::size_t thread = 0; thread < nbThreads; ++thread)
+        run(thread);
+}
@@ -0,0 +1,328 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PointLocator.h"
+// STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+// My includes
+#include "Reserve.h"
+
+PointLocator::PointLocator() : mMaxWeight(0.0), mBucketSize(1.0), mNbColumns(0), mNbRows(0)
+{
+
+}
+
+void PointLocator::build(std::span<const Vector2> points, std::span<const double> weights)
+{
+    mPoints.assign(points.begin(), points.end());
+    mWeights.assign(weights.begin(), weights.end());
+    mNeighborOffsets.clear();
+    mNeighbors.clear();
+    buildGrid();
+}
+
+void PointLocator::build(const VoronoiDiagram& diagram)
+{
+    constexpr Index NONE = VoronoiDiagram::INVALID_INDEX;
+    std::size_t nbSites = diagram.getNbSites();
+    mPoints.resize(nbSites);
+    mWeights.clear();
+    // The sites across the edges of each cell, the edges on the box have no twin
+    mNeighborOffsets.resize(nbSites + 1);
+    mNeighbors.clear();
+    reserveGeometrically(mNeighbors, 6 * nbSites); // Each edge has two sides
+    for (std::size_t i = 0; i < nbSites; ++i)
+    {
+        const VoronoiDiagram::Site* site = diagram.getSite(i);
+        mPoints[i] = site->point;
+        mNeighborOffsets[i] = static_cast<Index>(mNeighbors.size());
+        Index start = diagram.getFace(site->face)->outerComponent;
+        Index halfEdge = start;
+        while (halfEdge != NONE)
+        {
+            const VoronoiDiagram::HalfEdge& current = diagram.getHalfEdge(halfEdge);
+            if (current.twin != NONE)
+                mNeighbors.push_back(diagram.getFace(diagram.getHalfEdge(current.twin).incidentFace)->site);
+            halfEdge = current.next;
+            if (halfEdge == start)
+                break;
+        }
+    }
+    mNeighborOffsets.back() = static_cast<Index>(mNeighbors.size());
+    // The corners of the box are vertices of the diagram
+    const std::vector<VoronoiDiagram::Vertex>& vertices = diagram.getVertices();
+    if (!vertices.empty())
+    {
+        mDiagramBox = Box{vertices[0].point.x, vertices[0].point.y, vertices[0].point.x, vertices[0].point.y};
+        for (const VoronoiDiagram::Vertex& vertex : vertices)
+        {
+            mDiagramBox.left = std::min(mDiagramBox.left, vertex.point.x);
+            mDiagramBox.bottom = std::min(mDiagramBox.bottom, vertex.point.y);
+            mDiagramBox.right = std::max(mDiagramBox.right, vertex.point.x);
+            mDiagramBox.top = std::max(mDiagramBox.top, vertex.point.y);
+        }
+    }
+    else
+        mNeighborOffsets.clear();
+    buildGrid();
+}
+
+bool PointLocator::isEmpty() const
+{
+    return mPoints.empty();
+}
+
+std::size_t PointLocator::getNbSites() const
+{
+    return mPoints.size();
+}
+
+PointLocator::Index PointLocator::locate(const Vector2& point) const
+{
+    // Search the rings of buckets around point until the closest ring cannot contain a lower power
+    Index best = VoronoiDiagram::INVALID_INDEX;
+    if (mPoints.empty())
+        return best;
+    double bestPower = std::numeric_limits<double>::infinity();
+    int column = getColumn(point.x);
+    int row = getRow(point.y);
+    for (int ring = 0; ; ++ring)
+    {
+        double distance = getRingDistance(point, column, row, ring);
+        if (distance * distance - mMaxWeight >= bestPower)
+            break;
+        bool isInGrid = visitRing(column, row, ring, [&](Index site)
+        {
+            double power = getPower(point, site);
+            if (power < bestPower)
+            {
+                bestPower = power;
+                best = site;
+            }
+        });
+        if (!isInGrid)
+            break;
+    }
+    return best;
+}
+
+PointLocator::Index PointLocator::locate(const Vector2& point, Index hint) const
+{
+    // Inside the box, the segment from a site to point crosses the edge of a neighbor closer to point,
+    // a site without a closer neighbor is the one whose cell contains point
+    if (mNeighborOffsets.empty() || hint >= mPoints.size() || !mDiagramBox.contains(point))
+        return locate(point);
+    Index site = hint;
+    double power = getPower(point, site);
+    while (true)
+    {
+        Index next = site;
+        for (Index i = mNeighborOffsets[site]; i < mNeighborOffsets[site + 1]; ++i)
+        {
+            double neighborPower = getPower(point, mNeighbors[i]);
+            if (neighborPower < power)
+            {
+                power = neighborPower;
+                next = mNeighbors[i];
+            }
+        }
+        if (next == site)
+            return site;
+        site = next;
+    }
+}
+
+void PointLocator::findNearest(const Vector2& point, std::size_t k, std::vector<Index>& sites) const
+{
+    // Max heap of the k closest sites found so far
+    sites.clear();
+    if (k == 0 || mPoints.empty())
+        return;
+    auto getSquaredDistance = [this, &point](Index site)
+    {
+        Vector2 delta = mPoints[site] - point;
+        return delta.dot(delta);
+    };
+    auto isCloser = [&getSquaredDistance](Index lhs, Index rhs)
+    {
+        double lhsDistance = getSquaredDistance(lhs);
+        double rhsDistance = getSquaredDistance(rhs);
+        return lhsDistance < rhsDistance || (lhsDistance == rhsDistance && lhs < rhs);
+    };
+    int column = getColumn(point.x);
+    int row = getRow(point.y);
+    for (int ring = 0; ; ++ring)
+    {
+        double distance = getRingDistance(point, column, row, ring);
+        if (sites.size() == k && distance * distance > getSquaredDistance(sites.front()))
+            break;
+        bool isInGrid = visitRing(column, row, ring, [&](Index site)
+        {
+            if (sites.size() < k)
+            {
+                sites.push_back(site);
+                std::push_heap(sites.begin(), sites.end(), isCloser);
+            }
+            else if (isCloser(site, sites.front()))
+            {
+                std::pop_heap(sites.begin(), sites.end(), isCloser);
+                sites.back() = site;
+                std::push_heap(sites.begin(), sites.end(), isCloser);
+            }
+        });
+        if (!isInGrid)
+            break;
+    }
+    std::sort_heap(sites.begin(), sites.end(), isCloser);
+}
+
+void PointLocator::findInRadius(const Vector2& point, double radius, std::vector<Index>& sites) const
+{
+    sites.clear();
+    if (mPoints.empty() || !(radius >= 0.0))
+        return;
+    double squaredRadius = radius * radius;
+    int lastColumn = getColumn(point.x + radius);
+    int lastRow = getRow(point.y + radius);
+    for (int row = getRow(point.y - radius); row <= lastRow; ++row)
+    {
+        for (int column = getColumn(point.x - radius); column <= lastColumn; ++column)
+        {
+            std::size_t bucket = static_cast<std::size_t>(row) * mNbColumns + column;
+            for (Index i = mBucketOffsets[bucket]; i < mBucketOffsets[bucket + 1]; ++i)
+            {
+                Vector2 delta = mPoints[mBucketSites[i]] - point;
+                if (delta.dot(delta) <= squaredRadius)
+                    sites.push_back(mBucketSites[i]);
+            }
+        }
+    }
+    std::sort(sites.begin(), sites.end());
+}
+
+void PointLocator::buildGrid()
+{
+    mMaxWeight = mWeights.empty() ? 0.0 : *std::max_element(mWeights.begin(), mWeights.end());
+    mBucketOffsets.clear();
+    mBucketSites.clear();
+    mNbColumns = 0;
+    mNbRows = 0;
+    if (mPoints.empty())
+        return;
+    mBounds = Box{mPoints[0].x, mPoints[0].y, mPoints[0].x, mPoints[0].y};
+    for (const Vector2& point : mPoints)
+    {
+        mBounds.left = std::min(mBounds.left, point.x);
+        mBounds.bottom = std::min(mBounds.bottom, point.y);
+        mBounds.right = std::max(mBounds.right, point.x);
+        mBounds.top = std::max(mBounds.top, point.y);
+    }
+    // About one site per bucket, degenerate bounds are one row or one column of buckets
+    double width = mBounds.right - mBounds.left;
+    double height = mBounds.top - mBounds.bottom;
+    double nbSites = static_cast<double>(mPoints.size());
+    mBucketSize = std::sqrt(width * height / nbSites);
+    if (!(mBucketSize > 0.0))
+        mBucketSize = std::max(width, height) / nbSites;
+    if (!(mBucketSize > 0.0))
+        mBucketSize = 1.0;
+    mNbColumns = static_cast<int>(std::min(width / mBucketSize, nbSites)) + 1;
+    mNbRows = static_cast<int>(std::min(height / mBucketSize, nbSites)) + 1;
+    // Counting sort of the sites by bucket
+    std::size_t nbBuckets = static_cast<std::size_t>(mNbColumns) * mNbRows;
+    reserveGeometrically(mBucketOffsets, nbBuckets + 1);
+    mBucketOffsets.assign(nbBuckets + 1, 0);
+    for (const Vector2& point : mPoints)
+        ++mBucketOffsets[static_cast<std::size_t>(getRow(point.y)) * mNbColumns + getColumn(point.x) + 1];
+    for (std::size_t i = 0; i < nbBuckets; ++i)
+        mBucketOffsets[i + 1] += mBucketOffsets[i];
+    mBucketSites.resize(mPoints.size());
+    for (Index i = 0; i < mPoints.size(); ++i)
+    {
+        std::size_t bucket = static_cast<std::size_t>(getRow(mPoints[i].y)) * mNbColumns + getColumn(mPoints[i].x);
+        mBucketSites[mBucketOffsets[bucket]++] = i;
+    }
+    // The offsets were moved to the end of each bucket
+    for (std::size_t i = nbBuckets; i > 0; --i)
+        mBucketOffsets[i] = mBucketOffsets[i - 1];
+    mBucketOffsets[0] = 0;
+}
+
+double PointLocator::getPower(const Vector2& point, Index site) const
+{
+    Vector2 delta = mPoints[site] - point;
+    return mWeights.empty() ? delta.dot(delta) : delta.dot(delta) - mWeights[site];
+}
+
+int PointLocator::getColumn(double x) const
+{
+    return std::clamp(static_cast<int>(std::floor((x - mBounds.left) / mBucketSize)), 0, mNbColumns - 1);
+}
+
+int PointLocator::getRow(double y) const
+{
+    return std::clamp(static_cast<int>(std::floor((y - mBounds.bottom) / mBucketSize)), 0, mNbRows - 1);
+}
+
+double PointLocator::getRingDistance(const Vector2& point, int column, int row, int ring) const
+{
+    // Distance from point to the outside of the rings inside ring, a lower bound of the distance to its sites
+    if (ring == 0)
+        return 0.0;
+    double left = mBounds.left + (column - ring + 1) * mBucketSize;
+    double right = mBounds.left + (column + ring) * mBucketSize;
+    double bottom = mBounds.bottom + (row - ring + 1) * mBucketSize;
+    double top = mBounds.bottom + (row + ring) * mBucketSize;
+    return std::max(std::min({point.x - left, right - point.x, point.y - bottom, top - point.y}), 0.0);
+}
+
+template<typename F>
+bool PointLocator::visitRing(int column, int row, int ring, const F& f) const
+{
+    auto visitBucket = [this, &f](int bucketColumn, int bucketRow)
+    {
+        std::size_t bucket = static_cast<std::size_t>(bucketRow) * mNbColumns + bucketColumn;
+        for (Index i = mBucketOffsets[bucket]; i < mBucketOffsets[bucket + 1]; ++i)
+            f(mBucketSites[i]);
+    };
+    int firstColumn = column - ring;
+    int lastColumn = column + ring;
+    int firstRow = row - ring;
+    int lastRow = row + ring;
+    if (firstColumn < 0 && lastColumn >= mNbColumns && firstRow < 0 && lastRow >= mNbRows)
+        return false;
+    // Bottom and top rows, then the left and right columns without the corners
+    for (int bucketRow : {firstRow, lastRow})
+    {
+        if (bucketRow < 0 || bucketRow >= mNbRows)
+            continue;
+        for (int bucketColumn = std::max(firstColumn, 0); bucketColumn <= std::min(lastColumn, mNbColumns - 1); ++bucketColumn)
+            visitBucket(bucketColumn, bucketRow);
+        if (ring == 0)
+            return true;
+    }
+    for (int bucketColumn : {firstColumn, lastColumn})
+    {
+        if (bucketColumn < 0 || bucketColumn >= mNbColumns)
+            continue;
+        for (int bucketRow = std::max(firstRow + 1, 0); bucketRow <= std::min(lastRow - 1, mNbRows - 1); ++bucketRow)
+            visitBucket(bucketColumn, bucketRow);
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// STL
+#include <span>
+#include <vector>
+// My includes
+#include "VoronoiDiagram.h"
+
+// Index of the sites of a diagram to find the cell containing a point.
+// The sites are bucketed in a uniform grid of about one site per bucket, and if the index is built from a diagram,
+// the neighbors of each site are kept to walk from the cell found during the previous query.
+// The queries do not modify the index, they can be run concurrently.
+class PointLocator
+{
+public:
+    using Index = VoronoiDiagram::Index;
+
+    PointLocator();
+
+    // Index the sites, with weights the cells are the ones of the power diagram
+    void build(std::span<const Vector2> points, std::span<const double> weights = {});
+    // Index the sites and their neighbors in a diagram intersected with a box
+    void build(const VoronoiDiagram& diagram);
+
+    // Accessors
+    bool isEmpty() const;
+    std::size_t getNbSites() const;
+
+    // Site whose cell contains point, INVALID_INDEX if there is no site
+    Index locate(const Vector2& point) const;
+    // Walk from the cell of hint to the cell containing point, O(1) if point is in or next to the cell of hint
+    Index locate(const Vector2& point, Index hint) const;
+    // The k sites nearest to point, by increasing distance
+    void findNearest(const Vector2& point, std::size_t k, std::vector<Index>& sites) const;
+    // The sites at a distance at most radius from point, by increasing index
+    void findInRadius(const Vector2& point, double radius, std::vector<Index>& sites) const;
+
+private:
+    std::vector<Vector2> mPoints;
+    std::vector<double> mWeights; // Empty if the sites are not weighted
+    double mMaxWeight;
+    // Grid
+    Box mBounds;
+    double mBucketSize;
+    int mNbColumns;
+    int mNbRows;
+    std::vector<Index> mBucketOffsets; // The sites of bucket i are mBucketSites[mBucketOffsets[i]] to mBucketSites[mBucketOffsets[i + 1] - 1]
+    std::vector<Index> mBucketSites;
+    // Neighbors in the same layout, the walks stay in the box of the diagram
+    std::vector<Index> mNeighborOffsets;
+    std::vector<Index> mNeighbors;
+    Box mDiagramBox;
+
+    void buildGrid();
+    double getPower(const Vector2& point, Index site) const;
+    int getColumn(double x) const;
+    int getRow(double y) const;
+    double getRingDistance(const Vector2& point, int column, int row, int ring) const;
+    // Call f on the sites of each bucket of the ring, return false if the ring is outside of the grid
+    template<typename F>
+    bool visitRing(int column, int row, int ring, const F& f) const;
+};
@@ -15,19 +15,26 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-// TO DO: Replace raw pointers by std::unique_ptr
-
 #pragma once
 
 // STL
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <ostream>
+#include <string>
 #include <vector>
-#include <memory>
 
+// Max-heap of elements stored in a pool and referred to by handles.
+// The heap is 4-ary and holds the keys next to the handles so that sifting never touches the elements,
+// T must expose its priority as a member y.
 template<typename T>
 class PriorityQueue
 {
 public:
+    using Handle = std::uint32_t;
+    static constexpr Handle INVALID_HANDLE = std::numeric_limits<Handle>::max();
+
     PriorityQueue()
     {
 
@@ -37,112 +44,183 @@ public:
 
     bool isEmpty() const
     {
-        return mElements.empty();
+        return mHeap.empty();
+    }
+
+    std::size_t getSize() const
+    {
+        return mHeap.size();
+    }
+
+    const T& get(Handle handle) const
+    {
+        return mElements[handle];
+    }
+
+    const T& top() const
+    {
+        return mElements[mHeap.front().handle];
     }
 
     // Operations
 
-    std::unique_ptr<T> pop()
+    void reserve(std::size_t size)
+    {
+        mElements.reserve(size);
+        mPositions.reserve(size);
+        mHeap.reserve(size);
+    }
+
+    // Make room for four times as many elements as the most held at once for the next runs, as reserveHeadroom in
+    // Reserve.h
+    void reserveHeadroom()
     {
-        swap(0, mElements.size() - 1);
-        auto top = std::move(mElements.back());
-        mElements.pop_back();
-        siftDown(0);
-        return top;
+        std::size_t size = mElements.size();
+        if (mElements.capacity() < 2 * size + 16)
+        {
+            reserve(4 * size + 64);
+            mFreeHandles.reserve(4 * size + 64);
+        }
     }
 
-    void push(std::unique_ptr<T> elem)
+    // Remove all the elements, the storage is kept
+    void clear()
     {
-        elem->index = mElements.size();
-        mElements.emplace_back(std::move(elem));
-        siftUp(mElements.size() - 1);
+        mElements.clear();
+        mFreeHandles.clear();
+        mPositions.clear();
+        mHeap.clear();
     }
 
-    void update(std::size_t i)
+    T pop()
     {
-        int parent = getParent(i);
-        if(parent >= 0 && *mElements[parent] < *mElements[i])
-            siftUp(i);
+        Handle top = mHeap.front().handle;
+        Node last = mHeap.back();
+        mHeap.pop_back();
+        if (!mHeap.empty())
+            siftDown(0, last);
+        mFreeHandles.push_back(top);
+        return mElements[top];
+    }
+
+    Handle push(const T& elem)
+    {
+        Handle handle;
+        if (!mFreeHandles.empty())
+        {
+            handle = mFreeHandles.back();
+            mFreeHandles.pop_back();
+            mElements[handle] = elem;
+        }
         else
-            siftDown(i);
+        {
+            handle = static_cast<Handle>(mElements.size());
+            mElements.push_back(elem);
+            mPositions.push_back(0);
+        }
+        mHeap.emplace_back();
+        siftUp(mHeap.size() - 1, Node{elem.y, handle});
+        return handle;
     }
 
-    void remove(std::size_t i)
+    void remove(Handle handle)
     {
-        swap(i, mElements.size() - 1);
-        mElements.pop_back();
-        if (i < mElements.size())
-            update(i);
+        std::size_t i = mPositions[handle];
+        Node last = mHeap.back();
+        mHeap.pop_back();
+        if (i < mHeap.size())
+        {
+            if (i > 0 && mHeap[getParent(i)].key < last.key)
+                siftUp(i, last);
+            else
+                siftDown(i, last);
+        }
+        mFreeHandles.push_back(handle);
     }
 
     // Print 
 
-    std::ostream& print(std::ostream& os, int i = 0, std::string tabs = "") const
+    std::ostream& print(std::ostream& os, std::size_t i = 0, std::string tabs = "") const
     {
-        if(i < mElements.size())
+        if (i < mHeap.size())
         {
-            os << tabs << *mElements[i] << std::endl;
-            display(getLeftChild(i), tabs + '\t');
-            display(getRightChild(i), tabs + '\t');
+            os << tabs << mElements[mHeap[i].handle] << std::endl;
+            for (std::size_t j = getFirstChild(i); j < getFirstChild(i) + ARITY; ++j)
+                print(os, j, tabs + '\t');
         }
         return os;
     }
 
 private:
-    std::vector<std::unique_ptr<T>> mElements;
-
-    // Accessors
+    static constexpr std::size_t ARITY = 4;
 
-    int getParent(int i) const
+    struct Node
     {
-        return (i + 1) / 2 - 1;
-    }
+        double key;
+        Handle handle;
+    };
+
+    std::vector<T> mElements;
+    std::vector<Handle> mFreeHandles;
+    std::vector<std::size_t> mPositions; // Position in the heap of each handle
+    std::vector<Node> mHeap;
+
+    // Accessors
 
-    std::size_t getLeftChild(std::size_t i) const
+    std::size_t getParent(std::size_t i) const
     {
-        return 2 * (i + 1) - 1;
+        return (i - 1) / ARITY;
     }
 
-    std::size_t getRightChild(std::size_t i) const
+    std::size_t getFirstChild(std::size_t i) const
     {
-        return 2 * (i + 1);
+        return ARITY * i + 1;
     }
 
     // Operations
 
-    void siftDown(std::size_t i)
+    // Move the hole at i down until node can be put in it
+    void siftDown(std::size_t i, Node node)
     {
-        std::size_t left = getLeftChild(i);
-        std::size_t right = getRightChild(i);
-        std::size_t j = i;
-        if(left < mElements.size() && *mElements[j] < *mElements[left])
-            j = left;
-        if(right < mElements.size() && *mElements[j] < *mElements[right])
-            j = right;
-        if(j != i)
+        std::size_t size = mHeap.size();
+        while (true)
         {
-            swap(i, j);
-            siftDown(j);
+            std::size_t first = getFirstChild(i);
+            if (first >= size)
+                break;
+            std::size_t last = std::min(first + ARITY, size);
+            std::size_t j = first;
+            for (std::size_t k = first + 1; k < last; ++k)
+            {
+                if (mHeap[j].key < mHeap[k].key)
+                    j = k;
+            }
+            if (!(node.key < mHeap[j].key))
+                break;
+            place(i, mHeap[j]);
+            i = j;
         }
+        place(i, node);
     }
 
-    void siftUp(std::size_t i)
+    // Move the hole at i up until node can be put in it
+    void siftUp(std::size_t i, Node node)
     {
-        int parent = getParent(i);
-        if(parent >= 0 && *mElements[parent] < *mElements[i])
+        while (i > 0)
         {
-            swap(i, parent);
-            siftUp(parent);
+            std::size_t parent = getParent(i);
+            if (!(mHeap[parent].key < node.key))
+                break;
+            place(i, mHeap[parent]);
+            i = parent;
         }
+        place(i, node);
     }
 
-    inline void swap(std::size_t i, std::size_t j)
+    void place(std::size_t i, Node node)
     {
-        auto tmp = std::move(mElements[i]);
-        mElements[i] = std::move(mElements[j]);
-        mElements[j] = std::move(tmp);
-        mElements[i]->index = i;
-        mElements[j]->index = j;
+        mHeap[i] = node;
+        mPositions[node.handle] = i;
     }
 };
 
@@ -0,0 +1,110 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RadixSort.h"
+// STL
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <thread>
+// My includes
+#include "Parallel.h"
+
+namespace
+{
+    constexpr std::size_t RADIX_THRESHOLD = 1 << 14; // Below, std::sort is faster
+    constexpr std::size_t ITEMS_PER_THREAD = 1 << 18; // Minimum number of items for an additional thread
+    constexpr std::size_t MAX_NB_THREADS = 16;
+    constexpr int DIGIT_SIZE = 11;
+    constexpr std::size_t NB_BUCKETS = std::size_t(1) << DIGIT_SIZE;
+
+    std::size_t getNbThreads(std::size_t size)
+    {
+        std::size_t nbThreads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+        return std::max<std::size_t>(std::min({nbThreads, MAX_NB_THREADS, size / ITEMS_PER_THREAD}), 1);
+    }
+}
+
+std::uint64_t getDecreasingKey(double value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    // Flip all the bits of negative values and the sign bit of positive ones to get an increasing key
+    std::uint64_t increasingKey = (bits & (std::uint64_t(1) << 63)) ? ~bits : bits | (std::uint64_t(1) << 63);
+    return ~increasingKey;
+}
+
+void sortKeys(std::vector<SortKey>& keys, std::vector<SortKey>& buffer, std::vector<std::size_t>& threadsCounts)
+{
+    std::size_t size = keys.size();
+    if (size < RADIX_THRESHOLD)
+    {
+        std::sort(keys.begin(), keys.end(), [](const SortKey& lhs, const SortKey& rhs)
+        {
+            return lhs.key < rhs.key || (lhs.key == rhs.key && lhs.index < rhs.index);
+        });
+        return;
+    }
+    buffer.resize(size);
+    std::size_t nbThreads = getNbThreads(size);
+    // One histogram per thread, then offsets[bucket][thread] to keep the sort stable
+    // A single histogram is on the stack
+    std::array<std::size_t, NB_BUCKETS> singleCounts;
+    if (nbThreads > 1)
+        threadsCounts.resize(std::max(threadsCounts.size(), nbThreads * NB_BUCKETS));
+    std::size_t* counts = nbThreads > 1 ? threadsCounts.data() : singleCounts.data();
+    for (int shift = 0; shift < 64; shift += DIGIT_SIZE)
+    {
+        std::fill(counts, counts + nbThreads * NB_BUCKETS, 0);
+        parallelFor(nbThreads, size, [&](std::size_t thread, std::size_t begin, std::size_t end)
+        {
+            std::size_t* threadCounts = &counts[thread * NB_BUCKETS];
+            for (std::size_t i = begin; i < end; ++i)
+                ++threadCounts[(keys[i].key >> shift) & (NB_BUCKETS - 1)];
+        });
+        // Skip the pass if all the keys have the same digit
+        bool isSorted = false;
+        for (std::size_t bucket = 0; bucket < NB_BUCKETS && !isSorted; ++bucket)
+        {
+            std::size_t total = 0;
+            for (std::size_t thread = 0; thread < nbThreads; ++thread)
+                total += counts[thread * NB_BUCKETS + bucket];
+            isSorted = total == size;
+        }
+        if (isSorted)
+            continue;
+        // Turn the counts into offsets
+        std::size_t offset = 0;
+        for (std::size_t bucket = 0; bucket < NB_BUCKETS; ++bucket)
+        {
+            for (std::size_t thread = 0; thread < nbThreads; ++thread)
+            {
+                std::size_t count = counts[thread * NB_BUCKETS + bucket];
+                counts[thread * NB_BUCKETS + bucket] = offset;
+                offset += count;
+            }
+        }
+        // Scatter
+        parallelFor(nbThreads, size, [&](std::size_t thread, std::size_t begin, std::size_t end)
+        {
+            std::size_t* threadOffsets = &counts[thread * NB_BUCKETS];
+            for (std::size_t i = begin; i < end; ++i)
+                buffer[threadOffsets[(keys[i].key >> shift) & (NB_BUCKETS - 1)]++] = keys[i];
+        });
+        keys.swap(buffer);
+    }
+}
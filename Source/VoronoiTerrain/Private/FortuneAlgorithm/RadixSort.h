@@ -15,29 +15,22 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "Event.h"
-
-Event::Event(VoronoiDiagram::Site* site) : type(Type::SITE), y(site->point.y), index(-1), site(site)
-{
-
-}
-
-Event::Event(double y, Vector2 point, Arc* arc) : type(Type::CIRCLE), y(y), index(-1), point(point), arc(arc)
-{
+#pragma once
 
+// STL
+#include <cstdint>
+#include <vector>
 
-}
-bool operator<(const Event& lhs, const Event& rhs)
+struct SortKey
 {
-    return lhs.y < rhs.y;
-}
+    std::uint64_t key;
+    std::uint32_t index;
+};
 
-std::ostream& operator<<(std::ostream& os, const Event& event)
-{
-    if(event.type == Event::Type::SITE)
-        os << "S(" << event.site->index << ", " << event.y << ")";
-    else
-        os << "C(" << event.arc << ", " << event.y << ", " << event.point << ")";
-    return os;
-}
+// Map a double to an unsigned integer in decreasing order: a > b <=> getDecreasingKey(a) < getDecreasingKey(b)
+std::uint64_t getDecreasingKey(double value);
 
+// Sort the keys by increasing key, equal keys keep their relative order
+// Large inputs are sorted with a LSD radix sort whose histogram and scatter passes are split across threads,
+// buffer and counts are scratch kept by the caller so that the sort does not allocate once they are large enough
+void sortKeys(std::vector<SortKey>& keys, std::vector<SortKey>& buffer, std::vector<std::size_t>& counts);
@@ -0,0 +1,45 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// STL
+#include <algorithm>
+#include <vector>
+
+// The buffers are filled again every frame with about as many elements, they keep some headroom so that the small
+// changes of the diagram between two frames do not reallocate them
+
+// Grow geometrically so that a size slowly increasing between runs does not reallocate each time
+template<typename T>
+void reserveGeometrically(std::vector<T>& buffer, std::size_t size)
+{
+    if (buffer.capacity() < size)
+        buffer.reserve(std::max(size + size / 4 + 16, 2 * buffer.capacity()));
+}
+
+// Once a buffer is filled, make room for four times as many elements for the next runs, for the small buffers whose
+// size varies a lot between runs and has no useful bound, like the ones along the border of the diagram
+// The capacity left by push_back is at most twice the size, so the buffer always grows after its first run, then only
+// if its size doubles, so that a size drifting between runs does not reallocate each time
+template<typename T>
+void reserveHeadroom(std::vector<T>& buffer)
+{
+    std::size_t size = buffer.size();
+    if (buffer.capacity() < 2 * size + 16)
+        buffer.reserve(4 * size + 64);
+}
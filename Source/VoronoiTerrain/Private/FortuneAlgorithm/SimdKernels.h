@@ -0,0 +1,255 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// STL
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+// My includes
+#include "Vector2.h"
+
+// SSE2 is always available on x64, other targets use the scalar versions
+#ifndef FORTUNE_USE_SSE2
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define FORTUNE_USE_SSE2 1
+    #else
+        #define FORTUNE_USE_SSE2 0
+    #endif
+#endif
+
+#if FORTUNE_USE_SSE2
+    #include <emmintrin.h>
+#endif
+
+// The SIMD versions do exactly the same operations in the same order as the scalar ones, the results are identical
+
+// The circle events of cocircular sites, as on a grid, are all on the sweep line, but the ones computed after the first
+// vertex may be rounded slightly above it. They are accepted within this tolerance, relative to the ordinate of the
+// first site and to its height above the bottom of the circle, and moved onto the sweep line. Dropping them leaves arcs
+// of null width in the beachline, whose breakpoints then cross and corrupt the cells.
+// For the same reason, a breakpoint that starts at the center, up to this tolerance relative to the abscissas of the
+// first site and of the center, converges: its event is on the sweep line. The only exception is the arc of a site
+// below both its neighbors, its two breakpoints start at the site and diverge.
+constexpr double CIRCLE_EVENT_TOLERANCE = 256.0 * std::numeric_limits<double>::epsilon();
+
+// Bound of the rounding error of the determinant of a triplet, relative to the sum of the magnitudes of its two
+// products, as in the orientation predicate of Shewchuk. Below it, the sign of the determinant is noise and the sites
+// are aligned, otherwise the center of nearly aligned sites can be on the wrong side and the cells are corrupted.
+constexpr double ALIGNMENT_TOLERANCE = 4.0 * std::numeric_limits<double>::epsilon();
+
+// Abscissa of the breakpoint between the parabolas of point1 on the left and point2 on the right, l is the sweep line
+template<typename T>
+inline T computeBreakpointScalar(const BasicVector2<T>& point1, const BasicVector2<T>& point2, T l)
+{
+    T x1 = point1.x, y1 = point1.y, x2 = point2.x, y2 = point2.y;
+    // Particular cases: the parabolas are translated from each other, or one of them is still a vertical ray
+    if (y1 == y2)
+        return T(0.5) * (x1 + x2);
+    if (y1 == l)
+        return x1;
+    if (y2 == l)
+        return x2;
+    // Relative to point1, the breakpoint is the root u of (y2 - y1)u^2 + 2dx e1 u - e1(dx^2 + (y2 - y1)e2) = 0
+    // with ei = yi - l, whose discriminant is 4 e1 e2 |point2 - point1|^2. Its two forms below do not cancel and do
+    // not divide by y2 - y1, so the sites with nearly the same y get the same breakpoint as the ones with the same y.
+    T dx = x2 - x1;
+    T dy = y2 - y1;
+    T e1 = y1 - l;
+    T e2 = y2 - l;
+    T root = std::sqrt(e1 * e2 * (dx * dx + dy * dy));
+    T numerator = dx >= T(0) ? e1 * (dx * dx + dy * e2) : root - dx * e1;
+    T denominator = dx >= T(0) ? root + dx * e1 : dy;
+    return x1 + numerator / denominator;
+}
+
+// Breakpoints on the left and on the right of the arc of point2
+inline std::array<double, 2> computeBreakpoints(const Vector2& point1, const Vector2& point2, const Vector2& point3, double l)
+{
+#if FORTUNE_USE_SSE2
+    // Lane 0 is the left breakpoint, lane 1 the right one
+    __m128d x1 = _mm_set_pd(point2.x, point1.x);
+    __m128d y1 = _mm_set_pd(point2.y, point1.y);
+    __m128d x2 = _mm_set_pd(point3.x, point2.x);
+    __m128d y2 = _mm_set_pd(point3.y, point2.y);
+    __m128d ll = _mm_set1_pd(l);
+    __m128d dx = _mm_sub_pd(x2, x1);
+    __m128d dy = _mm_sub_pd(y2, y1);
+    __m128d e1 = _mm_sub_pd(y1, ll);
+    __m128d e2 = _mm_sub_pd(y2, ll);
+    __m128d root = _mm_sqrt_pd(_mm_mul_pd(_mm_mul_pd(e1, e2), _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))));
+    __m128d dxE1 = _mm_mul_pd(dx, e1);
+    auto select = [](__m128d mask, __m128d lhs, __m128d rhs) { return _mm_or_pd(_mm_and_pd(mask, lhs), _mm_andnot_pd(mask, rhs)); };
+    __m128d isRightOf = _mm_cmpge_pd(dx, _mm_setzero_pd());
+    __m128d numerator = select(isRightOf, _mm_mul_pd(e1, _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, e2))),
+        _mm_sub_pd(root, dxE1));
+    __m128d denominator = select(isRightOf, _mm_add_pd(root, dxE1), dy);
+    __m128d breakpoints = _mm_add_pd(x1, _mm_div_pd(numerator, denominator));
+    // Particular cases, from the lowest priority to the highest one
+    breakpoints = select(_mm_cmpeq_pd(y2, ll), x2, breakpoints);
+    breakpoints = select(_mm_cmpeq_pd(y1, ll), x1, breakpoints);
+    breakpoints = select(_mm_cmpeq_pd(y1, y2), _mm_mul_pd(_mm_set1_pd(0.5), _mm_add_pd(x1, x2)), breakpoints);
+    std::array<double, 2> result;
+    _mm_storeu_pd(result.data(), breakpoints);
+    return result;
+#else
+    return {computeBreakpointScalar(point1, point2, l), computeBreakpointScalar(point2, point3, l)};
+#endif
+}
+
+// Other scalar types are only a storage format for the sites, the sweep line, the breakpoints and the events are in double,
+// in float the rounding errors drop circle events and put sites in the wrong arcs, so the topology of the diagram breaks
+template<typename T>
+inline std::array<double, 2> computeBreakpoints(const BasicVector2<T>& point1, const BasicVector2<T>& point2,
+    const BasicVector2<T>& point3, double l)
+{
+    return computeBreakpoints(Vector2(point1), Vector2(point2), Vector2(point3), l);
+}
+
+// Circle event of the arcs of point1, point2 and point3, it exists if both breakpoints converge and it is below the sweep line
+template<typename T>
+inline bool computeCircleEventScalar(const BasicVector2<T>& point1, const BasicVector2<T>& point2,
+    const BasicVector2<T>& point3, T l, BasicVector2<T>& center, T& y)
+{
+    BasicVector2<T> v1 = (point1 - point2).getOrthogonal();
+    BasicVector2<T> v2 = (point2 - point3).getOrthogonal();
+    BasicVector2<T> delta = T(0.5) * (point3 - point1);
+    T det = v1.getDet(v2);
+    T t = delta.getDet(v2) / det;
+    center = T(0.5) * (point1 + point2) + t * v1;
+    // Nearly aligned sites have huge circles, center.y - r would cancel, the bottom is computed from point1 instead
+    BasicVector2<T> offset = T(0.5) * (point2 - point1) + t * v1;
+    T r = offset.getNorm();
+    y = offset.y > T(0) ? point1.y - offset.x * offset.x / (offset.y + r) : point1.y + offset.y - r;
+    // A breakpoint moves right if its left site is below its right site, it starts at the abscissa of the lowest one
+    bool leftMovingRight = point1.y < point2.y;
+    bool rightMovingRight = point2.y < point3.y;
+    T leftInitialX = leftMovingRight ? point1.x : point2.x;
+    T rightInitialX = rightMovingRight ? point2.x : point3.x;
+    T toleranceX = T(CIRCLE_EVENT_TOLERANCE) * (std::abs(point1.x) + std::abs(offset.x));
+    T minX = center.x - toleranceX;
+    T maxX = center.x + toleranceX;
+    // Aligned sites have no circle
+    bool isAligned = std::abs(det) <= T(ALIGNMENT_TOLERANCE) * (std::abs(v1.x * v2.y) + std::abs(v1.y * v2.x));
+    bool isValid = !isAligned && (leftMovingRight || !rightMovingRight) &&
+        ((leftMovingRight && leftInitialX < maxX) || (!leftMovingRight && leftInitialX > minX)) &&
+        ((rightMovingRight && rightInitialX < maxX) || (!rightMovingRight && rightInitialX > minX));
+    bool isBelow = y - l <= T(CIRCLE_EVENT_TOLERANCE) * (std::abs(point1.y) + (point1.y - y));
+    y = std::min(y, l);
+    return isValid && isBelow;
+}
+
+template<typename T>
+inline bool computeCircleEvent(const BasicVector2<T>& point1, const BasicVector2<T>& point2, const BasicVector2<T>& point3, double l,
+    BasicVector2<T>& center, double& y)
+{
+    Vector2 centerDouble;
+    bool exists = computeCircleEventScalar(Vector2(point1), Vector2(point2), Vector2(point3), l, centerDouble, y);
+    center = BasicVector2<T>(centerDouble);
+    return exists;
+}
+
+// Circle events of two triplets at once, bit i of the result is set if the event of triplets[i] exists
+inline unsigned int computeCircleEvents(const std::array<std::array<const Vector2*, 3>, 2>& triplets, double l,
+    std::array<Vector2, 2>& centers, std::array<double, 2>& ys)
+{
+#if FORTUNE_USE_SSE2
+    // Lane i is the triplet i
+    __m128d x1 = _mm_set_pd(triplets[1][0]->x, triplets[0][0]->x);
+    __m128d y1 = _mm_set_pd(triplets[1][0]->y, triplets[0][0]->y);
+    __m128d x2 = _mm_set_pd(triplets[1][1]->x, triplets[0][1]->x);
+    __m128d y2 = _mm_set_pd(triplets[1][1]->y, triplets[0][1]->y);
+    __m128d x3 = _mm_set_pd(triplets[1][2]->x, triplets[0][2]->x);
+    __m128d y3 = _mm_set_pd(triplets[1][2]->y, triplets[0][2]->y);
+    __m128d half = _mm_set1_pd(0.5);
+    // v1 = (point1 - point2)^T and v2 = (point2 - point3)^T with (x, y)^T = (-y, x)
+    __m128d signMask = _mm_set1_pd(-0.0);
+    __m128d v1x = _mm_xor_pd(_mm_sub_pd(y1, y2), signMask);
+    __m128d v1y = _mm_sub_pd(x1, x2);
+    __m128d v2x = _mm_xor_pd(_mm_sub_pd(y2, y3), signMask);
+    __m128d v2y = _mm_sub_pd(x2, x3);
+    __m128d deltaX = _mm_mul_pd(_mm_sub_pd(x3, x1), half);
+    __m128d deltaY = _mm_mul_pd(_mm_sub_pd(y3, y1), half);
+    __m128d detLeft = _mm_mul_pd(v1x, v2y);
+    __m128d detRight = _mm_mul_pd(v1y, v2x);
+    __m128d det = _mm_sub_pd(detLeft, detRight);
+    __m128d t = _mm_div_pd(_mm_sub_pd(_mm_mul_pd(deltaX, v2y), _mm_mul_pd(deltaY, v2x)), det);
+    __m128d centerX = _mm_add_pd(_mm_mul_pd(_mm_add_pd(x1, x2), half), _mm_mul_pd(v1x, t));
+    __m128d centerY = _mm_add_pd(_mm_mul_pd(_mm_add_pd(y1, y2), half), _mm_mul_pd(v1y, t));
+    __m128d offsetX = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(x2, x1), half), _mm_mul_pd(v1x, t));
+    __m128d offsetY = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(y2, y1), half), _mm_mul_pd(v1y, t));
+    __m128d r = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(offsetX, offsetX), _mm_mul_pd(offsetY, offsetY)));
+    __m128d isAbove = _mm_cmpgt_pd(offsetY, _mm_setzero_pd());
+    __m128d y = _mm_or_pd(
+        _mm_and_pd(isAbove, _mm_sub_pd(y1, _mm_div_pd(_mm_mul_pd(offsetX, offsetX), _mm_add_pd(offsetY, r)))),
+        _mm_andnot_pd(isAbove, _mm_sub_pd(_mm_add_pd(y1, offsetY), r)));
+    // Validity of the breakpoints
+    __m128d leftMovingRight = _mm_cmplt_pd(y1, y2);
+    __m128d rightMovingRight = _mm_cmplt_pd(y2, y3);
+    __m128d leftInitialX = _mm_or_pd(_mm_and_pd(leftMovingRight, x1), _mm_andnot_pd(leftMovingRight, x2));
+    __m128d rightInitialX = _mm_or_pd(_mm_and_pd(rightMovingRight, x2), _mm_andnot_pd(rightMovingRight, x3));
+    __m128d tolerance = _mm_set1_pd(CIRCLE_EVENT_TOLERANCE);
+    __m128d toleranceX = _mm_mul_pd(tolerance,
+        _mm_add_pd(_mm_andnot_pd(signMask, x1), _mm_andnot_pd(signMask, offsetX)));
+    __m128d minX = _mm_sub_pd(centerX, toleranceX);
+    __m128d maxX = _mm_add_pd(centerX, toleranceX);
+    __m128d isLeftValid = _mm_or_pd(_mm_and_pd(leftMovingRight, _mm_cmplt_pd(leftInitialX, maxX)),
+        _mm_andnot_pd(leftMovingRight, _mm_cmpgt_pd(leftInitialX, minX)));
+    __m128d isRightValid = _mm_or_pd(_mm_and_pd(rightMovingRight, _mm_cmplt_pd(rightInitialX, maxX)),
+        _mm_andnot_pd(rightMovingRight, _mm_cmpgt_pd(rightInitialX, minX)));
+    __m128d ll = _mm_set1_pd(l);
+    __m128d toleranceY = _mm_mul_pd(tolerance, _mm_add_pd(_mm_andnot_pd(signMask, y1), _mm_sub_pd(y1, y)));
+    __m128d isBelow = _mm_cmple_pd(_mm_sub_pd(y, ll), toleranceY);
+    y = _mm_min_pd(y, ll);
+    __m128d isAligned = _mm_cmple_pd(_mm_andnot_pd(signMask, det), _mm_mul_pd(_mm_set1_pd(ALIGNMENT_TOLERANCE),
+        _mm_add_pd(_mm_andnot_pd(signMask, detLeft), _mm_andnot_pd(signMask, detRight))));
+    __m128d isDiverging = _mm_andnot_pd(leftMovingRight, rightMovingRight);
+    __m128d exists = _mm_andnot_pd(_mm_or_pd(isAligned, isDiverging),
+        _mm_and_pd(_mm_and_pd(isLeftValid, isRightValid), isBelow));
+    std::array<double, 2> xs;
+    _mm_storeu_pd(xs.data(), centerX);
+    std::array<double, 2> cys;
+    _mm_storeu_pd(cys.data(), centerY);
+    _mm_storeu_pd(ys.data(), y);
+    centers[0] = Vector2(xs[0], cys[0]);
+    centers[1] = Vector2(xs[1], cys[1]);
+    return static_cast<unsigned int>(_mm_movemask_pd(exists));
+#else
+    unsigned int result = 0;
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        if (computeCircleEventScalar(*triplets[i][0], *triplets[i][1], *triplets[i][2], l, centers[i], ys[i]))
+            result |= 1u << i;
+    }
+    return result;
+#endif
+}
+
+template<typename T>
+inline unsigned int computeCircleEvents(const std::array<std::array<const BasicVector2<T>*, 3>, 2>& triplets, double l,
+    std::array<BasicVector2<T>, 2>& centers, std::array<double, 2>& ys)
+{
+    unsigned int result = 0;
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        if (computeCircleEvent(*triplets[i][0], *triplets[i][1], *triplets[i][2], l, centers[i], ys[i]))
+            result |= 1u << i;
+    }
+    return result;
+}
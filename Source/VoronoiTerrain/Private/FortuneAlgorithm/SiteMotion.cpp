@@ -0,0 +1,114 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SiteMotion.h"
+// STL
+#include <algorithm>
+// My includes
+#include "Parallel.h"
+#include "SimdKernels.h"
+
+namespace
+{
+    // Same operations as the SIMD version, for the sites that do not fill a pair
+    void integrateSite(SiteMotion& motion, std::size_t i, double dt, const Box& box)
+    {
+        double x = motion.xs[i] + motion.vxs[i] * dt;
+        double y = motion.ys[i] + motion.vys[i] * dt;
+        bool hitX = x <= box.left || x >= box.right;
+        bool hitY = y <= box.bottom || y >= box.top;
+        double sign = hitX != hitY ? -1.0 : 1.0;
+        motion.xs[i] = std::min(std::max(x, box.left), box.right);
+        motion.ys[i] = std::min(std::max(y, box.bottom), box.top);
+        motion.vxs[i] *= sign;
+        motion.vys[i] *= sign;
+    }
+}
+
+void SiteMotion::resize(std::size_t nbSites)
+{
+    xs.resize(nbSites);
+    ys.resize(nbSites);
+    vxs.resize(nbSites);
+    vys.resize(nbSites);
+}
+
+std::size_t SiteMotion::size() const
+{
+    return xs.size();
+}
+
+void SiteMotion::importPositions(std::span<const Vector2> points)
+{
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        xs[i] = points[i].x;
+        ys[i] = points[i].y;
+    }
+}
+
+void SiteMotion::exportPositions(std::vector<Vector2>& points) const
+{
+    points.resize(size());
+    for (std::size_t i = 0; i < points.size(); ++i)
+        points[i] = Vector2(xs[i], ys[i]);
+}
+
+void integrateSiteMotion(SiteMotion& motion, double dt, const Box& box, std::size_t begin, std::size_t end)
+{
+    std::size_t i = begin;
+#if FORTUNE_USE_SSE2
+    // Lane k is the site i + k, the pairs start on an even site to be aligned
+    if (i < end && i % 2 != 0)
+        integrateSite(motion, i++, dt, box);
+    double* xs = motion.xs.data();
+    double* ys = motion.ys.data();
+    double* vxs = motion.vxs.data();
+    double* vys = motion.vys.data();
+    __m128d dts = _mm_set1_pd(dt);
+    __m128d left = _mm_set1_pd(box.left);
+    __m128d bottom = _mm_set1_pd(box.bottom);
+    __m128d right = _mm_set1_pd(box.right);
+    __m128d top = _mm_set1_pd(box.top);
+    __m128d signMask = _mm_set1_pd(-0.0);
+    for (; i + 2 <= end; i += 2)
+    {
+        __m128d vx = _mm_load_pd(vxs + i);
+        __m128d vy = _mm_load_pd(vys + i);
+        __m128d x = _mm_add_pd(_mm_load_pd(xs + i), _mm_mul_pd(vx, dts));
+        __m128d y = _mm_add_pd(_mm_load_pd(ys + i), _mm_mul_pd(vy, dts));
+        // The velocity is reversed once per side reached, so it only changes if exactly one side is reached
+        __m128d hitX = _mm_or_pd(_mm_cmple_pd(x, left), _mm_cmpge_pd(x, right));
+        __m128d hitY = _mm_or_pd(_mm_cmple_pd(y, bottom), _mm_cmpge_pd(y, top));
+        __m128d flip = _mm_and_pd(_mm_xor_pd(hitX, hitY), signMask);
+        _mm_store_pd(xs + i, _mm_min_pd(_mm_max_pd(x, left), right));
+        _mm_store_pd(ys + i, _mm_min_pd(_mm_max_pd(y, bottom), top));
+        _mm_store_pd(vxs + i, _mm_xor_pd(vx, flip));
+        _mm_store_pd(vys + i, _mm_xor_pd(vy, flip));
+    }
+#endif
+    for (; i < end; ++i)
+        integrateSite(motion, i, dt, box);
+}
+
+void integrateSiteMotion(SiteMotion& motion, double dt, const Box& box, std::size_t nbThreads)
+{
+    parallelFor(std::max<std::size_t>(nbThreads, 1), motion.size(), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        integrateSiteMotion(motion, dt, box, begin, end);
+    });
+}
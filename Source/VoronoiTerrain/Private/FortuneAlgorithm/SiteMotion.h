@@ -0,0 +1,84 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// STL
+#include <cstddef>
+#include <new>
+#include <span>
+#include <vector>
+// My includes
+#include "Box.h"
+
+// Allocates on cache lines, so that the SIMD loads of the kernels are aligned
+template<typename T, std::size_t Alignment = 64>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    constexpr AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept
+    {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    friend bool operator==(const AlignedAllocator&, const AlignedAllocator&)
+    {
+        return true;
+    }
+};
+
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Positions and velocities of moving sites, one entry per site in each array.
+// The coordinates are in separate arrays so that the motion of several sites is integrated at once, the diagram
+// reads the positions exported as points.
+struct SiteMotion
+{
+    AlignedVector<double> xs;
+    AlignedVector<double> ys;
+    AlignedVector<double> vxs;
+    AlignedVector<double> vys;
+
+    void resize(std::size_t nbSites);
+    std::size_t size() const;
+    void importPositions(std::span<const Vector2> points); // points must have one point per site
+    void exportPositions(std::vector<Vector2>& points) const;
+};
+
+// Move the sites in [begin, end) during dt, a site that reaches a side of the box is clamped on it and its whole
+// velocity is reversed, twice if it reaches two sides at once. Disjoint ranges can be integrated concurrently.
+void integrateSiteMotion(SiteMotion& motion, double dt, const Box& box, std::size_t begin, std::size_t end);
+// All the sites, split in contiguous ranges over nbThreads
+void integrateSiteMotion(SiteMotion& motion, double dt, const Box& box, std::size_t nbThreads = 1);
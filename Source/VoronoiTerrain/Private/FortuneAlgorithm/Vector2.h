@@ -18,44 +18,113 @@
 #pragma once
 
 // STL
+#include <cmath>
 #include <ostream>
+#include <type_traits>
 
-// Declarations
+// Everything is inline so that the arithmetic of the sweep and of the clipping does not go through function calls,
+// the scalar type is float or double
 
-class Vector2;
-Vector2 operator-(Vector2 lhs, const Vector2& rhs);
-
-// Implementations
-
-class Vector2
+template<typename T>
+class BasicVector2
 {
 public:
-    double x;
-    double y;
+    using Scalar = T;
+
+    T x;
+    T y;
+
+    constexpr BasicVector2(T x = T(0), T y = T(0)) : x(x), y(y) {}
+
+    template<typename U>
+    explicit constexpr BasicVector2(const BasicVector2<U>& other) : x(static_cast<T>(other.x)), y(static_cast<T>(other.y)) {}
 
-	Vector2(double x = 0.0, double y = 0.0) : x(x), y(y) {}
-    
     // Unary operators
 
-    Vector2 operator-() const;
-    Vector2& operator+=(const Vector2& other);
-    Vector2& operator-=(const Vector2& other);
-    Vector2& operator*=(double t);
-    
+    constexpr BasicVector2 operator-() const
+    {
+        return BasicVector2(-x, -y);
+    }
+
+    constexpr BasicVector2& operator+=(const BasicVector2& other)
+    {
+        x += other.x;
+        y += other.y;
+        return *this;
+    }
+
+    constexpr BasicVector2& operator-=(const BasicVector2& other)
+    {
+        x -= other.x;
+        y -= other.y;
+        return *this;
+    }
+
+    constexpr BasicVector2& operator*=(T t)
+    {
+        x *= t;
+        y *= t;
+        return *this;
+    }
+
     // Other operations
-    
-    Vector2 getOrthogonal() const;
-    double dot(const Vector2& other) const;
-    double getNorm() const;
-    double getDistance(const Vector2& other) const;
-    double getDet(const Vector2& other) const;
-};
 
-// Binary operators
+    constexpr BasicVector2 getOrthogonal() const
+    {
+        return BasicVector2(-y, x);
+    }
 
-Vector2 operator+(Vector2 lhs, const Vector2& rhs);
-Vector2 operator-(Vector2 lhs, const Vector2& rhs);
-Vector2 operator*(double t, Vector2 vec);
-Vector2 operator*(Vector2 vec, double t);
-std::ostream& operator<<(std::ostream& os, const Vector2& vec);
+    constexpr T dot(const BasicVector2& other) const
+    {
+        return x * other.x + y * other.y;
+    }
+
+    T getNorm() const
+    {
+        return std::sqrt(x * x + y * y);
+    }
+
+    T getDistance(const BasicVector2& other) const
+    {
+        return (*this - other).getNorm();
+    }
+
+    constexpr T getDet(const BasicVector2& other) const
+    {
+        return x * other.y - y * other.x;
+    }
+
+    // Binary operators, the scalars are converted to T
+
+    friend constexpr BasicVector2 operator+(BasicVector2 lhs, const BasicVector2& rhs)
+    {
+        lhs += rhs;
+        return lhs;
+    }
+
+    friend constexpr BasicVector2 operator-(BasicVector2 lhs, const BasicVector2& rhs)
+    {
+        lhs -= rhs;
+        return lhs;
+    }
+
+    friend constexpr BasicVector2 operator*(T t, BasicVector2 vec)
+    {
+        vec *= t;
+        return vec;
+    }
+
+    friend constexpr BasicVector2 operator*(BasicVector2 vec, T t)
+    {
+        return t * vec;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const BasicVector2& vec)
+    {
+        os << "(" << vec.x << ", " << vec.y << ")";
+        return os;
+    }
+};
 
+using Vector2 = BasicVector2<double>;
+using Vector2f = BasicVector2<float>;
@@ -16,221 +16,488 @@
  */
 
 #include "VoronoiDiagram.h"
-// STL
-#include <unordered_set>
 
-VoronoiDiagram::VoronoiDiagram(const std::vector<Vector2>& points)
+template<typename T>
+BasicVoronoiDiagram<T>::BasicVoronoiDiagram() = default;
+
+template<typename T>
+BasicVoronoiDiagram<T>::BasicVoronoiDiagram(const std::vector<Vector2>& points)
+{
+    reset(points);
+}
+
+template<typename T>
+void BasicVoronoiDiagram<T>::reset(std::span<const Vector2> points)
 {
+    // Clearing keeps the capacity of the vectors
+    mSites.clear();
+    mFaces.clear();
+    mVertices.clear();
+    mHalfEdges.clear();
+    FORTUNE_STATISTICS(mStatistics = FortuneStatistics());
     mSites.reserve(points.size());
     mFaces.reserve(points.size());
-    for(std::size_t i = 0; i < points.size(); ++i)
+    // There are at most 2n - 5 vertices and 3n - 6 edges before the intersection with a box, the headroom is for the
+    // ones it adds
+    reserveGeometrically(mVertices, 2 * points.size());
+    reserveGeometrically(mHalfEdges, 6 * points.size());
+    for (std::size_t i = 0; i < points.size(); ++i)
     {
-        mSites.push_back(VoronoiDiagram::Site{i, points[i], nullptr});
-        mFaces.push_back(VoronoiDiagram::Face{&mSites.back(), nullptr});
-        mSites.back().face = &mFaces.back();
+        Index index = static_cast<Index>(i);
+        mSites.push_back(Site{index, points[i], index});
+        mFaces.push_back(Face{index, INVALID_INDEX});
     }
 }
 
-VoronoiDiagram::Site* VoronoiDiagram::getSite(std::size_t i)
+template<typename T>
+typename BasicVoronoiDiagram<T>::Site* BasicVoronoiDiagram<T>::getSite(std::size_t i)
 {
     return &mSites[i];
 }
 
-std::size_t VoronoiDiagram::getNbSites() const
+template<typename T>
+const typename BasicVoronoiDiagram<T>::Site* BasicVoronoiDiagram<T>::getSite(std::size_t i) const
+{
+    return &mSites[i];
+}
+
+template<typename T>
+std::size_t BasicVoronoiDiagram<T>::getNbSites() const
 {
     return mSites.size();
 }
 
-VoronoiDiagram::Face* VoronoiDiagram::getFace(std::size_t i)
+template<typename T>
+typename BasicVoronoiDiagram<T>::Face* BasicVoronoiDiagram<T>::getFace(std::size_t i)
+{
+    return &mFaces[i];
+}
+
+template<typename T>
+const typename BasicVoronoiDiagram<T>::Face* BasicVoronoiDiagram<T>::getFace(std::size_t i) const
 {
     return &mFaces[i];
 }
 
-const std::list<VoronoiDiagram::Vertex>& VoronoiDiagram::getVertices() const
+template<typename T>
+const typename BasicVoronoiDiagram<T>::Vertex& BasicVoronoiDiagram<T>::getVertex(Index i) const
+{
+    return mVertices[i];
+}
+
+template<typename T>
+const typename BasicVoronoiDiagram<T>::HalfEdge& BasicVoronoiDiagram<T>::getHalfEdge(Index i) const
+{
+    return mHalfEdges[i];
+}
+
+template<typename T>
+const std::vector<typename BasicVoronoiDiagram<T>::Vertex>& BasicVoronoiDiagram<T>::getVertices() const
 {
     return mVertices;
 }
 
-const std::list<VoronoiDiagram::HalfEdge>& VoronoiDiagram::getHalfEdges() const
+template<typename T>
+const std::vector<typename BasicVoronoiDiagram<T>::HalfEdge>& BasicVoronoiDiagram<T>::getHalfEdges() const
 {
     return mHalfEdges;
 }
 
-bool VoronoiDiagram::intersect(Box box)
+#if FORTUNE_ENABLE_STATISTICS
+template<typename T>
+const FortuneStatistics& BasicVoronoiDiagram<T>::getStatistics() const
+{
+    return mStatistics;
+}
+#endif
+
+template<typename T>
+bool BasicVoronoiDiagram<T>::intersect(Box box)
 {
+    FORTUNE_STATISTICS(auto start = FortuneStatistics::Clock::now());
+    // Only the faces with a vertex outside the box are walked, the others are left untouched
+    std::vector<VertexState>& vertexStates = mVertexStates;
+    reserveGeometrically(vertexStates, mVertices.size());
+    vertexStates.resize(mVertices.size());
+    for (std::size_t i = 0; i < mVertices.size(); ++i)
+        vertexStates[i] = box.contains(mVertices[i].point) ? INSIDE : OUTSIDE;
+    std::vector<bool>& dirtyFaces = mDirtyFaces;
+    reserveGeometrically(dirtyFaces, mFaces.size());
+    dirtyFaces.assign(mFaces.size(), false);
+    for (const HalfEdge& halfEdge : mHalfEdges)
+    {
+        if (halfEdge.incidentFace != INVALID_INDEX && vertexStates[halfEdge.origin] != INSIDE)
+            dirtyFaces[halfEdge.incidentFace] = true;
+    }
+    // A face without edges is the whole box if it is the only one
+    if (mFaces.size() == 1 && mFaces[0].outerComponent == INVALID_INDEX)
+        addBox(box, 0);
+    mRemovedHalfEdges.clear();
     bool error = false;
-    std::unordered_set<HalfEdge*> processedHalfEdges;
-    std::unordered_set<Vertex*> verticesToRemove;
-    for (const Site& site : mSites)
-    {
-        HalfEdge* halfEdge = site.face->outerComponent;
-        bool inside = box.contains(halfEdge->origin->point);
-        bool outerComponentDirty = !inside;
-        HalfEdge* incomingHalfEdge = nullptr; // First half edge coming in the box
-        HalfEdge* outgoingHalfEdge = nullptr; // Last half edge going out the box
-        Box::Side incomingSide = Box::Side::LEFT, outgoingSide = Box::Side::LEFT;
-        do
+    for (Index face = 0; face < mFaces.size(); ++face)
+    {
+        if (dirtyFaces[face] && !intersectFace(box, face))
+            error = true;
+    }
+    reserveHeadroom(mRemovedHalfEdges);
+    // Remove the half edges and the vertices outside the box
+    compact();
+    FORTUNE_STATISTICS(mStatistics.intersectTime += FortuneStatistics::getElapsedTime(start));
+    // Return the status
+    return !error;
+}
+
+template<typename T>
+typename BasicVoronoiDiagram<T>::Index BasicVoronoiDiagram<T>::createVertex(Vector2 point)
+{
+    mVertices.push_back(Vertex{point});
+    FORTUNE_STATISTICS(++mStatistics.nbCreatedVertices);
+    return static_cast<Index>(mVertices.size() - 1);
+}
+
+template<typename T>
+typename BasicVoronoiDiagram<T>::Index BasicVoronoiDiagram<T>::createCorner(Box box, typename Box::Side side)
+{
+    switch (side)
+    {
+        case Box::Side::LEFT:
+            return createVertex(Vector2(box.left, box.top));
+        case Box::Side::BOTTOM:
+            return createVertex(Vector2(box.left, box.bottom));
+        case Box::Side::RIGHT:
+            return createVertex(Vector2(box.right, box.bottom));
+        case Box::Side::TOP:
+            return createVertex(Vector2(box.right, box.top));
+        default:
+            return INVALID_INDEX;
+    }
+}
+
+template<typename T>
+typename BasicVoronoiDiagram<T>::Index BasicVoronoiDiagram<T>::createHalfEdge(Index face)
+{
+    Index halfEdge = static_cast<Index>(mHalfEdges.size());
+    mHalfEdges.emplace_back();
+    mHalfEdges.back().incidentFace = face;
+    FORTUNE_STATISTICS(++mStatistics.nbCreatedHalfEdges);
+    if (mFaces[face].outerComponent == INVALID_INDEX)
+        mFaces[face].outerComponent = halfEdge;
+    return halfEdge;
+}
+
+template<typename T>
+void BasicVoronoiDiagram<T>::exportCells(Cells& cells, bool withVertices) const
+{
+    // The cells are closed, each of their half edges gives one corner: its origin
+    cells.offsets.resize(mSites.size() + 1);
+    cells.points.clear();
+    cells.vertices.clear();
+    reserveGeometrically(cells.points, mHalfEdges.size());
+    if (withVertices)
+        reserveGeometrically(cells.vertices, mHalfEdges.size());
+    for (std::size_t i = 0; i < mSites.size(); ++i)
+    {
+        cells.offsets[i] = static_cast<Index>(cells.points.size());
+        Index start = mFaces[mSites[i].face].outerComponent;
+        Index halfEdge = start;
+        // A cell has at most all the half edges, bound the walk in case its cycle is broken
+        for (std::size_t j = 0; halfEdge != INVALID_INDEX && j < mHalfEdges.size(); ++j)
+        {
+            const HalfEdge& current = mHalfEdges[halfEdge];
+            if (current.origin != INVALID_INDEX)
+            {
+                cells.points.push_back(mVertices[current.origin].point);
+                if (withVertices)
+                    cells.vertices.push_back(current.origin);
+            }
+            halfEdge = current.next;
+            if (halfEdge == start)
+                break;
+        }
+    }
+    cells.offsets.back() = static_cast<Index>(cells.points.size());
+}
+
+template<typename T>
+bool BasicVoronoiDiagram<T>::intersectFace(Box box, Index face)
+{
+    // The faces are intersected in order, the half edges whose twin is in a previous face reuse its vertices
+    bool error = false;
+    auto isInside = [this](Index vertex)
+    {
+        return vertex >= mVertexStates.size() || mVertexStates[vertex] == INSIDE;
+    };
+    auto isProcessed = [this, face](Index halfEdge)
+    {
+        return halfEdge != INVALID_INDEX && mHalfEdges[halfEdge].incidentFace < face;
+    };
+    // The vertices of an edge which could not be intersected are not removed
+    auto keepVertices = [this, &error](const HalfEdge& halfEdge)
+    {
+        for (Index vertex : {halfEdge.origin, halfEdge.destination})
+        {
+            if (vertex < mVertexStates.size() && mVertexStates[vertex] == OUTSIDE)
+                mVertexStates[vertex] = KEPT;
+        }
+        error = true;
+    };
+    Index start = mFaces[face].outerComponent;
+    Index halfEdge = start;
+    bool inside = isInside(mHalfEdges[halfEdge].origin);
+    bool outerComponentDirty = !inside;
+    Index incomingHalfEdge = INVALID_INDEX; // First half edge coming in the box
+    Index outgoingHalfEdge = INVALID_INDEX; // Last half edge going out the box
+    typename Box::Side incomingSide = Box::Side::LEFT, outgoingSide = Box::Side::LEFT;
+    // The cycle is open if the diagram was bounded by FortuneAlgorithm::clip, it starts and ends outside the box
+    do
+    {
+        HalfEdge& current = mHalfEdges[halfEdge];
+        bool nextInside = isInside(current.destination);
+        Index nextHalfEdge = current.next;
+        if (!inside || !nextInside)
         {
-            std::array<Box::Intersection, 2> intersections;
-            int nbIntersections = box.getIntersections(halfEdge->origin->point, halfEdge->destination->point, intersections);
-            bool nextInside = box.contains(halfEdge->destination->point);
-            HalfEdge* nextHalfEdge = halfEdge->next;
-            // The two points are outside the box 
+            std::array<typename Box::Intersection, 2> intersections;
+            int nbIntersections = getIntersections(box, halfEdge, intersections);
+            // A vertex exactly on a side of the box is inside, the edge leaves or enters the box at this vertex
+            bool isOnSide = nbIntersections == 0 && inside != nextInside;
+            if (isOnSide)
+            {
+                const Vector2& vertex = mVertices[inside ? current.origin : current.destination].point;
+                const Vector2& other = mVertices[inside ? current.destination : current.origin].point;
+                intersections[0] = box.getFirstIntersection(vertex, other - vertex);
+                intersections[0].point = vertex;
+                nbIntersections = 1;
+            }
+            // The two points are outside the box
             if (!inside && !nextInside)
             {
                 // The edge is outside the box
                 if (nbIntersections == 0)
-                {
-                    verticesToRemove.emplace(halfEdge->origin);
                     removeHalfEdge(halfEdge);
-                }
                 // The edge crosses twice the frontiers of the box
                 else if (nbIntersections == 2)
                 {
-                    verticesToRemove.emplace(halfEdge->origin);
-                    if (processedHalfEdges.find(halfEdge->twin) != processedHalfEdges.end())
+                    if (isProcessed(current.twin))
                     {
-                        halfEdge->origin = halfEdge->twin->destination;
-                        halfEdge->destination = halfEdge->twin->origin;
+                        current.origin = mHalfEdges[current.twin].destination;
+                        current.destination = mHalfEdges[current.twin].origin;
                     }
                     else
                     {
-                        halfEdge->origin = createVertex(intersections[0].point);
-                        halfEdge->destination = createVertex(intersections[1].point);
+                        current.origin = createVertex(intersections[0].point);
+                        current.destination = createVertex(intersections[1].point);
                     }
-                    if (outgoingHalfEdge != nullptr)
+                    if (outgoingHalfEdge != INVALID_INDEX)
                         link(box, outgoingHalfEdge, outgoingSide, halfEdge, intersections[0].side);
-                    if (incomingHalfEdge == nullptr)
+                    if (incomingHalfEdge == INVALID_INDEX)
                     {
                        incomingHalfEdge = halfEdge;
                        incomingSide = intersections[0].side;
                     }
                     outgoingHalfEdge = halfEdge;
                     outgoingSide = intersections[1].side;
-                    processedHalfEdges.emplace(halfEdge);
                 }
                 else
-                    error = true;
+                    keepVertices(current);
             }
             // The edge is going outside the box
             else if (inside && !nextInside)
             {
                 if (nbIntersections == 1)
                 {
-                    if (processedHalfEdges.find(halfEdge->twin) != processedHalfEdges.end())
-                        halfEdge->destination = halfEdge->twin->origin;
+                    if (isProcessed(current.twin))
+                        current.destination = mHalfEdges[current.twin].origin;
                     else
-                        halfEdge->destination = createVertex(intersections[0].point);
+                        current.destination = isOnSide ? current.origin : createVertex(intersections[0].point);
                     outgoingHalfEdge = halfEdge;
                     outgoingSide = intersections[0].side;
-                    processedHalfEdges.emplace(halfEdge);
                 }
                 else
-                    error = true;
+                    keepVertices(current);
             }
             // The edge is coming inside the box
             else if (!inside && nextInside)
             {
                 if (nbIntersections == 1)
                 {
-                    verticesToRemove.emplace(halfEdge->origin);
-                    if (processedHalfEdges.find(halfEdge->twin) != processedHalfEdges.end())
-                        halfEdge->origin = halfEdge->twin->destination;
+                    if (isProcessed(current.twin))
+                        current.origin = mHalfEdges[current.twin].destination;
                     else
-                        halfEdge->origin = createVertex(intersections[0].point);
-                    if (outgoingHalfEdge != nullptr)
+                        current.origin = isOnSide ? current.destination : createVertex(intersections[0].point);
+                    if (outgoingHalfEdge != INVALID_INDEX)
                         link(box, outgoingHalfEdge, outgoingSide, halfEdge, intersections[0].side);
-                    if (incomingHalfEdge == nullptr)
+                    if (incomingHalfEdge == INVALID_INDEX)
                     {
                        incomingHalfEdge = halfEdge;
                        incomingSide = intersections[0].side;
                     }
-                    processedHalfEdges.emplace(halfEdge);
                 }
                 else
-                    error = true;
+                    keepVertices(current);
             }
-            halfEdge = nextHalfEdge;
-            // Update inside
-            inside = nextInside;
-        } while (halfEdge != site.face->outerComponent);
-        // Link the last and the first half edges inside the box
-        if (outerComponentDirty && incomingHalfEdge != nullptr)
-            link(box, outgoingHalfEdge, outgoingSide, incomingHalfEdge, incomingSide);
-        // Set outer component
-        if (outerComponentDirty)
-            site.face->outerComponent = incomingHalfEdge;
+        }
+        halfEdge = nextHalfEdge;
+        // Update inside
+        inside = nextInside;
+    } while (halfEdge != start && halfEdge != INVALID_INDEX);
+    // Link the last and the first half edges inside the box
+    if (outerComponentDirty && incomingHalfEdge != INVALID_INDEX && outgoingHalfEdge != INVALID_INDEX)
+        link(box, outgoingHalfEdge, outgoingSide, incomingHalfEdge, incomingSide);
+    // Set outer component
+    if (outerComponentDirty)
+    {
+        // No edge in the box, either the box is in the face or the face is outside the box
+        bool isBoxInside = incomingHalfEdge == INVALID_INDEX && !error && containsBox(box, face);
+        mFaces[face].outerComponent = incomingHalfEdge;
+        if (isBoxInside)
+            addBox(box, face);
     }
-    // Remove vertices
-    for (auto& vertex : verticesToRemove)
-        removeVertex(vertex);
-    // Return the status
     return !error;
 }
 
-VoronoiDiagram::Vertex* VoronoiDiagram::createVertex(Vector2 point)
+template<typename T>
+int BasicVoronoiDiagram<T>::getIntersections(Box box, Index halfEdge, std::array<typename Box::Intersection, 2>& intersections) const
 {
-    mVertices.emplace_back();
-    mVertices.back().point = point;
-    mVertices.back().it = std::prev(mVertices.end());
-    return &mVertices.back();
+    // Both half edges of an edge are intersected in the same direction so that they agree on the result
+    const HalfEdge& current = mHalfEdges[halfEdge];
+    const Vector2& origin = mVertices[current.origin].point;
+    const Vector2& destination = mVertices[current.destination].point;
+    // The points are computed on the bisector of the sites, the vertices of nearly aligned sites are far and inaccurate
+    BasicVector2<double> linePoint;
+    BasicVector2<double> lineDirection;
+    if (current.twin != INVALID_INDEX && mHalfEdges[current.twin].incidentFace != INVALID_INDEX)
+    {
+        BasicVector2<double> site(mSites[mFaces[current.incidentFace].site].point);
+        BasicVector2<double> otherSite(mSites[mFaces[mHalfEdges[current.twin].incidentFace].site].point);
+        linePoint = 0.5 * (site + otherSite);
+        lineDirection = (otherSite - site).getOrthogonal();
+    }
+    if (current.twin == INVALID_INDEX || halfEdge < current.twin)
+        return box.getIntersections(origin, destination, linePoint, lineDirection, intersections);
+    int nbIntersections = box.getIntersections(destination, origin, linePoint, lineDirection, intersections);
+    if (nbIntersections == 2)
+        std::swap(intersections[0], intersections[1]);
+    return nbIntersections;
 }
 
-VoronoiDiagram::Vertex* VoronoiDiagram::createCorner(Box box, Box::Side side)
+template<typename T>
+bool BasicVoronoiDiagram<T>::containsBox(Box box, Index face) const
 {
-    switch (side)
+    // The center of the box must be on the left of all the half edges of the face
+    Vector2 center(T(0.5) * (box.left + box.right), T(0.5) * (box.bottom + box.top));
+    Index start = mFaces[face].outerComponent;
+    Index halfEdge = start;
+    do
     {
-        case Box::Side::LEFT:
-            return createVertex(Vector2(box.left, box.top));
-        case Box::Side::BOTTOM:
-            return createVertex(Vector2(box.left, box.bottom));
-        case Box::Side::RIGHT:
-            return createVertex(Vector2(box.right, box.bottom));
-        case Box::Side::TOP:
-            return createVertex(Vector2(box.right, box.top));
-        default:
-            return nullptr;
-    }
+        const HalfEdge& current = mHalfEdges[halfEdge];
+        const Vector2& origin = mVertices[current.origin].point;
+        if ((mVertices[current.destination].point - origin).getDet(center - origin) < T(0))
+            return false;
+        halfEdge = current.next;
+    } while (halfEdge != start && halfEdge != INVALID_INDEX);
+    return true;
 }
 
-VoronoiDiagram::HalfEdge* VoronoiDiagram::createHalfEdge(Face* face)
+template<typename T>
+void BasicVoronoiDiagram<T>::addBox(Box box, Index face)
 {
-    mHalfEdges.emplace_back();
-    mHalfEdges.back().incidentFace = face;
-    mHalfEdges.back().it = std::prev(mHalfEdges.end());
-    if(face->outerComponent == nullptr)
-        face->outerComponent = &mHalfEdges.back();
-    return &mHalfEdges.back();
+    // Cycle through the corners in counterclockwise order
+    std::array<Index, 4> halfEdges;
+    for (std::size_t side = 0; side < 4; ++side)
+        halfEdges[side] = createHalfEdge(face);
+    for (std::size_t side = 0; side < 4; ++side)
+    {
+        HalfEdge& halfEdge = mHalfEdges[halfEdges[side]];
+        halfEdge.origin = createCorner(box, static_cast<typename Box::Side>(side));
+        halfEdge.next = halfEdges[(side + 1) % 4];
+        halfEdge.prev = halfEdges[(side + 3) % 4];
+    }
+    for (std::size_t side = 0; side < 4; ++side)
+        mHalfEdges[halfEdges[side]].destination = mHalfEdges[halfEdges[(side + 1) % 4]].origin;
+    mFaces[face].outerComponent = halfEdges[0];
 }
 
-void VoronoiDiagram::link(Box box, HalfEdge* start, Box::Side startSide, HalfEdge* end, Box::Side endSide)
+template<typename T>
+void BasicVoronoiDiagram<T>::link(Box box, Index start, typename Box::Side startSide, Index end, typename Box::Side endSide)
 {
-    HalfEdge* halfEdge = start;
+    Index halfEdge = start;
+    Index face = mHalfEdges[start].incidentFace;
     int side = static_cast<int>(startSide);
     while (side != static_cast<int>(endSide))
     {
         side = (side + 1) % 4;
-        halfEdge->next = createHalfEdge(start->incidentFace);
-        halfEdge->next->prev = halfEdge;
-        halfEdge->next->origin = halfEdge->destination;
-        halfEdge->next->destination = createCorner(box, static_cast<Box::Side>(side));
-        halfEdge = halfEdge->next;
+        Index next = createHalfEdge(face);
+        Index corner = createCorner(box, static_cast<typename Box::Side>(side));
+        mHalfEdges[halfEdge].next = next;
+        mHalfEdges[next].prev = halfEdge;
+        mHalfEdges[next].origin = mHalfEdges[halfEdge].destination;
+        mHalfEdges[next].destination = corner;
+        halfEdge = next;
     }
-    halfEdge->next = createHalfEdge(start->incidentFace);
-    halfEdge->next->prev = halfEdge;
-    end->prev = halfEdge->next;
-    halfEdge->next->next = end;
-    halfEdge->next->origin = halfEdge->destination;
-    halfEdge->next->destination = end->origin;
+    Index next = createHalfEdge(face);
+    mHalfEdges[halfEdge].next = next;
+    mHalfEdges[next].prev = halfEdge;
+    mHalfEdges[end].prev = next;
+    mHalfEdges[next].next = end;
+    mHalfEdges[next].origin = mHalfEdges[halfEdge].destination;
+    mHalfEdges[next].destination = mHalfEdges[end].origin;
 }
 
-void VoronoiDiagram::removeVertex(Vertex* vertex)
+template<typename T>
+void BasicVoronoiDiagram<T>::removeHalfEdge(Index halfEdge)
 {
-    mVertices.erase(vertex->it);
+    mHalfEdges[halfEdge].incidentFace = INVALID_INDEX;
+    mRemovedHalfEdges.push_back(halfEdge);
+    FORTUNE_STATISTICS(++mStatistics.nbRemovedHalfEdges);
 }
 
-void VoronoiDiagram::removeHalfEdge(HalfEdge* halfEdge)
+template<typename T>
+void BasicVoronoiDiagram<T>::compact()
 {
-    mHalfEdges.erase(halfEdge->it);
+    // The removed half edges are replaced by the last ones, only the links to the moved half edges are updated
+    std::sort(mRemovedHalfEdges.begin(), mRemovedHalfEdges.end());
+    for (Index hole : mRemovedHalfEdges)
+    {
+        while (!mHalfEdges.empty() && mHalfEdges.back().incidentFace == INVALID_INDEX)
+            mHalfEdges.pop_back();
+        if (hole >= mHalfEdges.size())
+            break;
+        Index moved = static_cast<Index>(mHalfEdges.size() - 1);
+        mHalfEdges[hole] = mHalfEdges[moved];
+        mHalfEdges.pop_back();
+        const HalfEdge& halfEdge = mHalfEdges[hole];
+        if (halfEdge.twin < mHalfEdges.size())
+            mHalfEdges[halfEdge.twin].twin = hole;
+        if (halfEdge.prev < mHalfEdges.size())
+            mHalfEdges[halfEdge.prev].next = hole;
+        if (halfEdge.next < mHalfEdges.size())
+            mHalfEdges[halfEdge.next].prev = hole;
+        if (mFaces[halfEdge.incidentFace].outerComponent == moved)
+            mFaces[halfEdge.incidentFace].outerComponent = hole;
+    }
+    // The vertices keep their order, they are renumbered only if some of them are outside the box
+    std::vector<Index>& vertexIndices = mVertexIndices;
+    reserveGeometrically(vertexIndices, mVertices.size());
+    vertexIndices.resize(mVertices.size());
+    Index nbVertices = 0;
+    for (Index i = 0; i < mVertices.size(); ++i)
+    {
+        vertexIndices[i] = nbVertices;
+        if (i >= mVertexStates.size() || mVertexStates[i] != OUTSIDE)
+            mVertices[nbVertices++] = mVertices[i];
+    }
+    FORTUNE_STATISTICS(mStatistics.nbRemovedVertices += mVertices.size() - nbVertices);
+    if (nbVertices == mVertices.size())
+        return;
+    mVertices.resize(nbVertices);
+    for (HalfEdge& halfEdge : mHalfEdges)
+    {
+        halfEdge.origin = vertexIndices[halfEdge.origin];
+        halfEdge.destination = vertexIndices[halfEdge.destination];
+    }
 }
 
+// Instantiations
+
+template class BasicVoronoiDiagram<float>;
+template class BasicVoronoiDiagram<double>;
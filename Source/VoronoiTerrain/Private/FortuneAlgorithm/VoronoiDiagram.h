@@ -18,90 +18,133 @@
 #pragma once
 
 // STL
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
 #include <vector>
-#include <list>
 // My includes
 #include "Box.h"
+#include "FortuneStatistics.h"
+#include "Reserve.h"
 
-class FortuneAlgorithm;
+template<typename T>
+class BasicFortuneAlgorithm;
 
-class VoronoiDiagram
+template<typename T>
+class BasicVoronoiDiagram
 {
 public:
-    struct HalfEdge;
-    struct Face;
+    using Vector2 = BasicVector2<T>;
+    using Box = BasicBox<T>;
+
+    // Elements are stored contiguously and linked with 32-bit indices
+    using Index = std::uint32_t;
+    static constexpr Index INVALID_INDEX = std::numeric_limits<Index>::max();
 
     struct Site
     {
-        std::size_t index;
+        Index index;
         Vector2 point;
-        Face* face;
+        Index face;
     };
 
     struct Vertex
     {
         Vector2 point;
-
-    private:
-        friend VoronoiDiagram;
-        std::list<Vertex>::iterator it;
     };
 
     struct HalfEdge
     {
-        Vertex* origin = nullptr;
-        Vertex* destination = nullptr;
-        HalfEdge* twin = nullptr;
-        Face* incidentFace;
-        HalfEdge* prev = nullptr;
-        HalfEdge* next = nullptr;
-
-    private:
-        friend VoronoiDiagram;
-        std::list<HalfEdge>::iterator it;
+        Index origin = INVALID_INDEX;
+        Index destination = INVALID_INDEX;
+        Index twin = INVALID_INDEX;
+        Index incidentFace = INVALID_INDEX; // INVALID_INDEX once the half edge is removed
+        Index prev = INVALID_INDEX;
+        Index next = INVALID_INDEX;
     };
 
     struct Face
     {
-        Site* site;
-        HalfEdge* outerComponent;
+        Index site;
+        Index outerComponent;
+    };
+
+    // Cells in compressed sparse row form: the corners of the cell of site i are points[offsets[i]] to
+    // points[offsets[i + 1] - 1] in counterclockwise order, vertices holds their indices in the diagram if requested
+    struct Cells
+    {
+        std::vector<Index> offsets;
+        std::vector<Vector2> points;
+        std::vector<Index> vertices;
     };
 
-    VoronoiDiagram(const std::vector<Vector2>& points);
+    BasicVoronoiDiagram();
+    explicit BasicVoronoiDiagram(const std::vector<Vector2>& points);
 
     // Remove copy operations
-    VoronoiDiagram(const VoronoiDiagram&) = delete;
-    VoronoiDiagram& operator=(const VoronoiDiagram&) = delete;
+    BasicVoronoiDiagram(const BasicVoronoiDiagram&) = delete;
+    BasicVoronoiDiagram& operator=(const BasicVoronoiDiagram&) = delete;
 
     // Move operations
-    VoronoiDiagram(VoronoiDiagram&&) = default;
-    VoronoiDiagram& operator=(VoronoiDiagram&&) = default;
+    BasicVoronoiDiagram(BasicVoronoiDiagram&&) = default;
+    BasicVoronoiDiagram& operator=(BasicVoronoiDiagram&&) = default;
+
+    // Replace the sites and clear the diagram, the storage is kept
+    void reset(std::span<const Vector2> points);
 
     // Accessors
     Site* getSite(std::size_t i);
+    const Site* getSite(std::size_t i) const;
     std::size_t getNbSites() const;
     Face* getFace(std::size_t i);
-    const std::list<Vertex>& getVertices() const;
-    const std::list<HalfEdge>& getHalfEdges() const;
+    const Face* getFace(std::size_t i) const;
+    const Vertex& getVertex(Index i) const;
+    const HalfEdge& getHalfEdge(Index i) const;
+    const std::vector<Vertex>& getVertices() const;
+    const std::vector<HalfEdge>& getHalfEdges() const;
 
-    // Intersection with a box
+    // Intersection with a box, the diagram must be bounded and the storage is compacted afterwards
     bool intersect(Box box);
 
+    // Export the cells once the diagram is intersected with a box, the buffers of cells keep their capacity
+    void exportCells(Cells& cells, bool withVertices = false) const;
+
+#if FORTUNE_ENABLE_STATISTICS
+    const FortuneStatistics& getStatistics() const;
+#endif
+
 private:
     std::vector<Site> mSites;
     std::vector<Face> mFaces;
-    std::list<Vertex> mVertices;
-    std::list<HalfEdge> mHalfEdges;
+    std::vector<Vertex> mVertices;
+    std::vector<HalfEdge> mHalfEdges;
+    // Scratch buffers of intersect, kept between runs
+    enum VertexState : std::uint8_t {INSIDE, OUTSIDE, KEPT};
+    std::vector<VertexState> mVertexStates;
+    std::vector<bool> mDirtyFaces; // Faces with a vertex outside the box
+    std::vector<Index> mRemovedHalfEdges;
+    std::vector<Index> mVertexIndices;
+#if FORTUNE_ENABLE_STATISTICS
+    FortuneStatistics mStatistics;
+#endif
 
     // Diagram construction
-    friend FortuneAlgorithm;
+    friend BasicFortuneAlgorithm<T>;
 
-    Vertex* createVertex(Vector2 point);
-    Vertex* createCorner(Box box, Box::Side side);
-    HalfEdge* createHalfEdge(Face* face);
+    Index createVertex(Vector2 point);
+    Index createCorner(Box box, typename Box::Side side);
+    Index createHalfEdge(Index face);
 
     // Intersection with a box
-    void link(Box box, HalfEdge* start, Box::Side startSide, HalfEdge* end, Box::Side endSide);
-    void removeVertex(Vertex* vertex);
-    void removeHalfEdge(HalfEdge* halfEdge);
+    bool intersectFace(Box box, Index face);
+    int getIntersections(Box box, Index halfEdge, std::array<typename Box::Intersection, 2>& intersections) const;
+    bool containsBox(Box box, Index face) const;
+    void addBox(Box box, Index face);
+    void link(Box box, Index start, typename Box::Side startSide, Index end, typename Box::Side endSide);
+    void removeHalfEdge(Index halfEdge);
+    void compact();
 };
+
+using VoronoiDiagram = BasicVoronoiDiagram<double>;
+using VoronoiDiagramf = BasicVoronoiDiagram<float>;
@@ -74,26 +74,27 @@
 //     {
 //         const VoronoiDiagram::Site* site = diagram.getSite(i);
 //         Vector2 center = site->point;
-//         VoronoiDiagram::Face* face = site->face;
-//         VoronoiDiagram::HalfEdge* halfEdge = face->outerComponent;
-//         if (halfEdge == nullptr)
+//         const VoronoiDiagram::Face* face = diagram.getFace(site->face);
+//         VoronoiDiagram::Index halfEdge = face->outerComponent;
+//         if (halfEdge == VoronoiDiagram::INVALID_INDEX)
 //             continue;
-//         while (halfEdge->prev != nullptr)
+//         while (diagram.getHalfEdge(halfEdge).prev != VoronoiDiagram::INVALID_INDEX)
 //         {
-//             halfEdge = halfEdge->prev;
+//             halfEdge = diagram.getHalfEdge(halfEdge).prev;
 //             if (halfEdge == face->outerComponent)
 //                 break;
 //         }
-//         VoronoiDiagram::HalfEdge* start = halfEdge;
-//         while (halfEdge != nullptr)
+//         VoronoiDiagram::Index start = halfEdge;
+//         while (halfEdge != VoronoiDiagram::INVALID_INDEX)
 //         {
-//             if (halfEdge->origin != nullptr && halfEdge->destination != nullptr)
+//             const VoronoiDiagram::HalfEdge& edge = diagram.getHalfEdge(halfEdge);
+//             if (edge.origin != VoronoiDiagram::INVALID_INDEX && edge.destination != VoronoiDiagram::INVALID_INDEX)
 //             {
-//                 Vector2 origin = (halfEdge->origin->point - center) * OFFSET + center;
-//                 Vector2 destination = (halfEdge->destination->point - center) * OFFSET + center;
+//                 Vector2 origin = (diagram.getVertex(edge.origin).point - center) * OFFSET + center;
+//                 Vector2 destination = (diagram.getVertex(edge.destination).point - center) * OFFSET + center;
 //                 drawEdge(window, origin, destination, sf::Color::Red);
 //             }
-//             halfEdge = halfEdge->next;
+//             halfEdge = edge.next;
 //             if (halfEdge == start)
 //                 break;
 //         }
@@ -117,7 +118,7 @@
 //     algorithm.bound(Box{-0.05, -0.05, 1.05, 1.05}); // Take the bounding box slightly bigger than the intersection box
 //     duration = std::chrono::steady_clock::now() - start;
 //     std::cout << "bounding: " << std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() << "ms" << '\n';
-//     VoronoiDiagram diagram = algorithm.getDiagram();
+//     VoronoiDiagram diagram = std::move(algorithm.getDiagram());
 //
 //     // Intersect the diagram with a box
 //     start = std::chrono::steady_clock::now();
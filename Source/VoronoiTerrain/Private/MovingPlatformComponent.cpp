@@ -7,11 +7,9 @@
 
 UMovingPlatformComponent::UMovingPlatformComponent()
 {
-	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bCanEverTick = false;
 
 	PlatformIndex = -1;
-	TargetPosition = FVector::ZeroVector;
-	TargetScale = 1.0f;
 	
 	SetupPlatformCollision();
 }
@@ -24,23 +22,9 @@ void UMovingPlatformComponent::BeginPlay()
 
 }
 
-void UMovingPlatformComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
-{
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-
-	// move to target position
-	SetWorldLocation(TargetPosition);
-
-	// scaling
-	FVector TargetScaleVector(TargetScale, TargetScale, 0.3f);
-	SetWorldScale3D(TargetScaleVector);
-}
-
 void UMovingPlatformComponent::InitializePlatform(int InPlatformIndex, const FVector& InitialPosition, float InitialScale)
 {
 	PlatformIndex = InPlatformIndex;
-	TargetPosition = InitialPosition;
-	TargetScale = InitialScale;
 	
 	SetWorldLocation(InitialPosition);
 	SetWorldScale3D(FVector(InitialScale, InitialScale, 0.3f)); // 0.1 for flat cylinder
@@ -52,10 +36,17 @@ void UMovingPlatformComponent::InitializePlatform(int InPlatformIndex, const FVe
 		PlatformIndex, InitialPosition.X, InitialPosition.Y, InitialPosition.Z, InitialScale);
 }
 
-void UMovingPlatformComponent::UpdatePlatformData(const FVector& NewPosition, float NewScale)
+bool UMovingPlatformComponent::UpdatePlatformTransform(const FTransform& NewTransform, float Tolerance)
 {
-	TargetPosition = NewPosition;
-	TargetScale = NewScale;
+	// Skipping the still platforms saves their propagation to the children, the physics and the renderer
+	if (GetComponentTransform().Equals(NewTransform, Tolerance))
+	{
+		return false;
+	}
+
+	// Location, rotation and scale in one move, without teleport so that the physics bodies resting on the platform are carried
+	SetWorldTransform(NewTransform, false, nullptr, ETeleportType::None);
+	return true;
 }
 
 
@@ -3,6 +3,9 @@
 
 #include "MovingPlatformManager.h"
 #include "MovingPlatformComponent.h"
+#include "VoronoiAllocationCounter.h"
+#include "VoronoiTerrainStats.h"
+#include "Async/ParallelFor.h"
 #include "Engine/Engine.h"
 #include "Engine/World.h"
 #include "Components/SceneComponent.h"
@@ -11,6 +14,49 @@
 #include "UObject/ConstructorHelpers.h"
 #include "Materials/Material.h"
 
+DEFINE_STAT(STAT_VoronoiManagerTick);
+DEFINE_STAT(STAT_VoronoiUpdatePoints);
+DEFINE_STAT(STAT_VoronoiRelaxPoints);
+DEFINE_STAT(STAT_VoronoiGenerateEdges);
+DEFINE_STAT(STAT_VoronoiPositionsAndRadii);
+DEFINE_STAT(STAT_VoronoiUpdatePlatforms);
+DEFINE_STAT(STAT_VoronoiSites);
+DEFINE_STAT(STAT_VoronoiCellEdges);
+DEFINE_STAT(STAT_VoronoiComponentsUpdated);
+DEFINE_STAT(STAT_VoronoiSitesMemory);
+DEFINE_STAT(STAT_VoronoiDiagramMemory);
+DEFINE_STAT(STAT_VoronoiCellsMemory);
+DEFINE_STAT(STAT_VoronoiCellMetricsMemory);
+DEFINE_STAT(STAT_VoronoiPlatformTransformsMemory);
+
+TRACE_DECLARE_INT_COUNTER(VoronoiSiteCount, TEXT("VoronoiTerrain/Sites"));
+TRACE_DECLARE_INT_COUNTER(VoronoiCellEdgeCount, TEXT("VoronoiTerrain/Cell Edges"));
+TRACE_DECLARE_INT_COUNTER(VoronoiComponentsUpdated, TEXT("VoronoiTerrain/Components Updated"));
+
+namespace
+{
+	template<typename T, typename Allocator>
+	SIZE_T GetAllocatedSize(const std::vector<T, Allocator>& Buffer)
+	{
+		return Buffer.capacity() * sizeof(T);
+	}
+
+	// Sites integrated and cells measured by each task of ParallelFor
+	constexpr int32 SitesPerTask = 1 << 16;
+	constexpr int32 CellsPerTask = 1024;
+	// Up to this many platforms ParallelFor runs the tasks on the calling thread, above it the task graph may allocate
+	// to schedule them. The threads of the diagram library are started once and kept.
+	constexpr int32 MaxInlineParallelForPlatforms = FMath::Min(SitesPerTask, CellsPerTask);
+
+	// Unlike the copy assignment, keep the allocation of Destination when it is large enough
+	template<typename T>
+	void CopyArray(TArray<T>& Destination, const TArray<T>& Source)
+	{
+		Destination.Reset();
+		Destination.Append(Source);
+	}
+}
+
 AMovingPlatformManager::AMovingPlatformManager()
 {
 	PrimaryActorTick.bCanEverTick = true;
@@ -36,11 +82,16 @@ void AMovingPlatformManager::OnConstruction(const FTransform& Transform)
 
 	if (ShowDebugEdges)
 	{
-		for (const auto& EdgesPerSite : VoronoiEdges)
+		const VoronoiDiagram::Cells& Cells = VoronoiFrames[CurrentVoronoiFrame].Cells;
+		for (int i = 0; i < PlatformCount; i++)
 		{
-			for (const auto& Edge : EdgesPerSite)
+			const std::size_t Begin = Cells.offsets[i];
+			const std::size_t End = Cells.offsets[i + 1];
+			for (std::size_t j = Begin; j < End; ++j)
 			{
-				DrawDebugLine(GetWorld(), Edge.Get<0>() + GetActorLocation(), Edge.Get<1>() + GetActorLocation(), FColor::Blue, true, -1, 0, 5);
+				const Vector2& Origin = Cells.points[j];
+				const Vector2& Destination = Cells.points[j + 1 < End ? j + 1 : Begin];
+				DrawDebugLine(GetWorld(), FVector(Origin.x, Origin.y, 0) + GetActorLocation(), FVector(Destination.x, Destination.y, 0) + GetActorLocation(), FColor::Blue, true, -1, 0, 5);
 			}
 		}
 	}
@@ -57,17 +108,209 @@ void AMovingPlatformManager::OnConstruction(const FTransform& Transform)
 
 void AMovingPlatformManager::Tick(float DeltaTime)
 {
+	SCOPE_CYCLE_COUNTER(STAT_VoronoiManagerTick);
+	TRACE_CPUPROFILER_EVENT_SCOPE(AMovingPlatformManager::Tick);
+
 	Super::Tick(DeltaTime);
 
 	// Update transforms
-	UpdatePlatformTransformData(DeltaTime);
+	PendingDeltaTime += DeltaTime;
+	const float Alpha = ComputeAsynchronously ? StepAsynchronously(DeltaTime) : StepSynchronously();
+	InterpolatePlatformTransforms(Alpha);
 	UpdatePlatforms();
 }
 
+void AMovingPlatformManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// The task refers to the manager
+	CancelVoronoiTask();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+float AMovingPlatformManager::StepSynchronously()
+{
+	VORONOI_ALLOCATION_SCOPE(NumStepAllocations);
+	CancelVoronoiTask();
+
+	const FVoronoiStepSettings Settings = GetStepSettings();
+	if (!UseFixedTimestep)
+	{
+		UpdatePlatformTransformData(PendingDeltaTime, Settings, VoronoiFrames[1 - CurrentVoronoiFrame]);
+		PendingDeltaTime = 0.0f;
+		PublishVoronoiFrame(false);
+		return 1.0f;
+	}
+
+	// Only the last two states are shown, the steps before them just move the sites
+	const float Step = GetFixedTimestep();
+	const int32 NumSteps = ConsumeFixedSteps();
+	for (int32 i = 0; i < NumSteps; i++)
+	{
+		if (i + 2 < NumSteps)
+		{
+			UpdateRandomPoints(Step, Settings);
+		}
+		else
+		{
+			UpdatePlatformTransformData(Step, Settings, VoronoiFrames[1 - CurrentVoronoiFrame]);
+			PublishVoronoiFrame(true);
+		}
+	}
+	return FMath::Clamp(PendingDeltaTime / Step, 0.0f, 1.0f);
+}
+
+float AMovingPlatformManager::StepAsynchronously(float DeltaTime)
+{
+	// The launch of the task is counted with the frame it fills
+	VORONOI_ALLOCATION_SCOPE(NumStepAllocations);
+
+	// The frame of the finished task becomes current and the next step is launched at once, so that the task
+	// runs during the rest of the frame
+	if (VoronoiTask.IsValid() && VoronoiTask.IsCompleted())
+	{
+		VoronoiTask = UE::Tasks::FTask();
+		PublishVoronoiFrame(false);
+		InterpolationTime = 0.0f;
+		InterpolationDuration = VoronoiTaskDeltaTime;
+	}
+	if (!VoronoiTask.IsValid())
+	{
+		LaunchVoronoiTask();
+	}
+
+	// The frame is reached in the time it simulates, the platforms lag one task behind
+	InterpolationTime += DeltaTime;
+	return InterpolationDuration > 0.0f ? FMath::Min(InterpolationTime / InterpolationDuration, 1.0f) : 1.0f;
+}
+
+float AMovingPlatformManager::GetFixedTimestep() const
+{
+	return 1.0f / FMath::Max(SimulationRate, 1.0f);
+}
+
+int32 AMovingPlatformManager::ConsumeFixedSteps()
+{
+	const float Step = GetFixedTimestep();
+	int32 NumSteps = FMath::FloorToInt32(PendingDeltaTime / Step);
+	if (NumSteps > MaxSubsteps)
+	{
+		// A long frame drops the time it cannot catch up instead of making the next frames longer too
+		NumSteps = FMath::Max(MaxSubsteps, 1);
+		PendingDeltaTime = NumSteps * Step;
+	}
+	PendingDeltaTime -= NumSteps * Step;
+	return NumSteps;
+}
+
+void AMovingPlatformManager::LaunchVoronoiTask()
+{
+	// With a fixed timestep, the task waits for a whole step and runs all the steps due at once
+	const int32 NumSteps = UseFixedTimestep ? ConsumeFixedSteps() : 1;
+	if (NumSteps == 0)
+	{
+		return;
+	}
+	const float Step = UseFixedTimestep ? GetFixedTimestep() : PendingDeltaTime;
+	if (!UseFixedTimestep)
+	{
+		PendingDeltaTime = 0.0f;
+	}
+	VoronoiTaskDeltaTime = NumSteps * Step;
+
+	// The task only reads its copy of the properties, Blueprints may change them while it runs
+	FVoronoiFrame& Frame = VoronoiFrames[1 - CurrentVoronoiFrame];
+	VoronoiTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, &Frame, NumSteps, Step, Settings = GetStepSettings()]()
+	{
+		VORONOI_ALLOCATION_SCOPE(NumStepAllocations);
+		for (int32 i = 0; i + 1 < NumSteps && !VoronoiTaskCancelled; i++)
+		{
+			UpdateRandomPoints(Step, Settings);
+		}
+		if (!VoronoiTaskCancelled)
+		{
+			UpdatePlatformTransformData(Step, Settings, Frame);
+		}
+	});
+}
+
+void AMovingPlatformManager::CancelVoronoiTask()
+{
+	if (!VoronoiTask.IsValid())
+	{
+		return;
+	}
+
+	// The task stops between two stages, its frame is incomplete and never published
+	VoronoiTaskCancelled = true;
+	VoronoiTask.Wait();
+	VoronoiTask = UE::Tasks::FTask();
+	VoronoiTaskCancelled = false;
+	NumStepAllocations = 0;
+}
+
+void AMovingPlatformManager::PublishVoronoiFrame(bool StartFromPreviousFrame)
+{
+	const FVoronoiFrame& PreviousFrame = VoronoiFrames[CurrentVoronoiFrame];
+	CurrentVoronoiFrame = 1 - CurrentVoronoiFrame;
+	const FVoronoiFrame& Frame = VoronoiFrames[CurrentVoronoiFrame];
+	CheckStepAllocations(Frame.Positions.Num());
+
+	// The platforms jump to the frame if their number changed
+	if (PlatformPositions.Num() != Frame.Positions.Num())
+	{
+		CopyArray(PlatformPositions, Frame.Positions);
+		CopyArray(PlatformRadii, Frame.Radii);
+	}
+	// The interpolation starts from the previous simulated state, or from where the platforms are shown
+	if (StartFromPreviousFrame && PreviousFrame.Positions.Num() == Frame.Positions.Num())
+	{
+		CopyArray(InterpolationStartPositions, PreviousFrame.Positions);
+		CopyArray(InterpolationStartRadii, PreviousFrame.Radii);
+	}
+	else
+	{
+		CopyArray(InterpolationStartPositions, PlatformPositions);
+		CopyArray(InterpolationStartRadii, PlatformRadii);
+	}
+}
+
+void AMovingPlatformManager::CheckStepAllocations(int32 NumPlatforms)
+{
+#if VORONOI_COUNT_ALLOCATIONS
+	// Each frame is filled once before its buffers are sized, the first one by InitializePlatformTransformData. The
+	// steps are only free of allocations while ParallelFor runs inline, the larger ones are not checked.
+	const int32 NumAllocations = NumStepAllocations.exchange(0);
+	ensureMsgf(NumTransformDataUpdates <= 1 || NumPlatforms > MaxInlineParallelForPlatforms || NumAllocations == 0,
+		TEXT("MovingPlatformManager: Update %d of the platform transforms made %d allocations"), NumTransformDataUpdates, NumAllocations);
+#endif
+}
+
+void AMovingPlatformManager::InterpolatePlatformTransforms(float Alpha)
+{
+	const FVoronoiFrame& Frame = VoronoiFrames[CurrentVoronoiFrame];
+	if (Frame.Positions.Num() != PlatformPositions.Num() || InterpolationStartPositions.Num() != PlatformPositions.Num())
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < PlatformPositions.Num(); i++)
+	{
+		PlatformPositions[i] = FMath::Lerp(InterpolationStartPositions[i], Frame.Positions[i], Alpha);
+		PlatformRadii[i] = FMath::Lerp(InterpolationStartRadii[i], Frame.Radii[i], Alpha);
+	}
+}
+
 void AMovingPlatformManager::CreatePlatforms()
 {
 	// Clean up
 	DestroyPlatforms();
+
+	if (UseInstancedPlatforms)
+	{
+		CreatePlatformInstances();
+		return;
+	}
 	
 	for (int i = 0; i < PlatformCount; i++)
 	{
@@ -110,25 +353,88 @@ void AMovingPlatformManager::CreatePlatforms()
 	UE_LOG(LogTemp, Log, TEXT("MovingPlatformManager: Created %d platforms"), PlatformComponents.Num());
 }
 
+void AMovingPlatformManager::CreatePlatformInstances()
+{
+	// Plain instances rather than a hierarchical component, as every instance moves every frame its cluster tree
+	// would be rebuilt each time
+	PlatformInstances = NewObject<UInstancedStaticMeshComponent>(this, TEXT("PlatformInstances"));
+	if (!PlatformInstances)
+	{
+		return;
+	}
+
+	PlatformInstances->RegisterComponent();
+	PlatformInstances->AttachToComponent(RootComponent, FAttachmentTransformRules::KeepWorldTransform);
+	PlatformInstances->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	PlatformInstances->SetSimulatePhysics(false);
+	SetupPlatformAppearance(PlatformInstances);
+
+	const FVector MeshSize = GetPlatformMeshSize();
+	const int32 NumPlatforms = FMath::Min3(PlatformCount, PlatformPositions.Num(), PlatformRadii.Num());
+	PlatformInstanceTransforms.SetNumUninitialized(NumPlatforms);
+	for (int32 i = 0; i < NumPlatforms; i++)
+	{
+		PlatformInstanceTransforms[i] = GetPlatformTransform(i, MeshSize);
+	}
+	PlatformInstances->AddInstances(PlatformInstanceTransforms, false, true);
+
+	UE_LOG(LogTemp, Log, TEXT("MovingPlatformManager: Created %d platform instances"), PlatformInstances->GetInstanceCount());
+}
+
+void AMovingPlatformManager::UpdatePlatformInstances()
+{
+	// One batch for all the instances, the render state of the component is marked dirty once
+	const int32 NumPlatforms = FMath::Min(PlatformInstances->GetInstanceCount(), PlatformPositions.Num());
+	const FVector MeshSize = GetPlatformMeshSize();
+	PlatformInstanceTransforms.SetNumUninitialized(NumPlatforms, EAllowShrinking::No);
+	for (int32 i = 0; i < NumPlatforms; i++)
+	{
+		PlatformInstanceTransforms[i] = GetPlatformTransform(i, MeshSize);
+	}
+	// No teleport, the physics bodies resting on the platforms are carried as with the components
+	PlatformInstances->BatchUpdateInstancesTransforms(0, PlatformInstanceTransforms, true, true, false);
+
+	SET_DWORD_STAT(STAT_VoronoiComponentsUpdated, NumPlatforms);
+	TRACE_COUNTER_SET(VoronoiComponentsUpdated, NumPlatforms);
+}
+
+FVector AMovingPlatformManager::GetPlatformMeshSize() const
+{
+	return PlatformMesh ? PlatformMesh->GetBounds().GetBox().GetSize() : FVector(1.0f);
+}
+
+FTransform AMovingPlatformManager::GetPlatformTransform(int32 Platform, const FVector& MeshSize) const
+{
+	// The radius of the cell across the mesh and a flat height
+	const float Scale = PlatformRadii[Platform] / MeshSize.X * 2.0f;
+	return FTransform(FQuat::Identity, GetActorLocation() + PlatformPositions[Platform], FVector(Scale, Scale, 0.3f));
+}
+
 void AMovingPlatformManager::UpdatePlatforms()
 {
-	// Update platforms with current Voronoi data
-	for (int32 i = 0; i < PlatformCount; i++)
+	SCOPE_CYCLE_COUNTER(STAT_VoronoiUpdatePlatforms);
+	TRACE_CPUPROFILER_EVENT_SCOPE(AMovingPlatformManager::UpdatePlatforms);
+
+	if (PlatformInstances)
 	{
-		FVector MeshSize = FVector(1.0f);
-		
-		if (PlatformMesh)
-		{
-			MeshSize = PlatformMesh->GetBounds().GetBox().GetSize();
-			UE_LOG(LogTemp, Log, TEXT("Selected mesh size: (%f, %f, %f)"), MeshSize.X, MeshSize.Y, MeshSize.Z);
-		}
-		
-		if (PlatformComponents[i] && IsValid(PlatformComponents[i]))
+		UpdatePlatformInstances();
+		return;
+	}
+
+	// Update platforms with current Voronoi data, in one pass as the components do not tick
+	const FVector MeshSize = GetPlatformMeshSize();
+	const int32 NumPlatforms = FMath::Min3(PlatformComponents.Num(), PlatformPositions.Num(), PlatformRadii.Num());
+	int32 NumUpdated = 0;
+	for (int32 i = 0; i < NumPlatforms; i++)
+	{
+		UMovingPlatformComponent* Platform = PlatformComponents[i];
+		if (Platform && IsValid(Platform) && Platform->UpdatePlatformTransform(GetPlatformTransform(i, MeshSize), PlatformMoveTolerance))
 		{
-			FVector WorldPosition = GetActorLocation() + PlatformPositions[i];
-			PlatformComponents[i]->UpdatePlatformData(WorldPosition, PlatformRadii[i] / MeshSize.X * 2.0f);
+			NumUpdated++;
 		}
 	}
+	SET_DWORD_STAT(STAT_VoronoiComponentsUpdated, NumUpdated);
+	TRACE_COUNTER_SET(VoronoiComponentsUpdated, NumUpdated);
 }
 
 void AMovingPlatformManager::DestroyPlatforms()
@@ -141,9 +447,15 @@ void AMovingPlatformManager::DestroyPlatforms()
 		}
 	}
 	PlatformComponents.Empty();
+
+	if (PlatformInstances && IsValid(PlatformInstances))
+	{
+		PlatformInstances->DestroyComponent();
+	}
+	PlatformInstances = nullptr;
 }
 
-void AMovingPlatformManager::SetupPlatformAppearance(UMovingPlatformComponent* Platform)
+void AMovingPlatformManager::SetupPlatformAppearance(UStaticMeshComponent* Platform)
 {
 	if (!Platform) return;
 	
@@ -158,6 +470,14 @@ void AMovingPlatformManager::SetupPlatformAppearance(UMovingPlatformComponent* P
 	}
 }
 
+void AMovingPlatformManager::PreEditChange(FProperty* PropertyAboutToChange)
+{
+	// The task in flight steps with the previous properties, it is dropped so that the edit applies at once
+	CancelVoronoiTask();
+
+	Super::PreEditChange(PropertyAboutToChange);
+}
+
 void AMovingPlatformManager::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
 {
 	Super::PostEditChangeProperty(PropertyChangedEvent);
@@ -170,7 +490,8 @@ void AMovingPlatformManager::PostEditChangeProperty(FPropertyChangedEvent& Prope
 			PropertyName == TEXT("RandomSeed") ||
 			PropertyName == TEXT("MinHeight") ||
 			PropertyName == TEXT("MaxHeight") || 
-			PropertyName == TEXT("VoronoiBounds"))
+			PropertyName == TEXT("VoronoiBounds") ||
+			PropertyName == TEXT("UseInstancedPlatforms"))
 		{
 			CreatePlatforms();
 		}
@@ -192,7 +513,9 @@ float AMovingPlatformManager::GetRandomVelocityInRange(const FRandomStream Rando
 void AMovingPlatformManager::GenerateRandomPoints()
 {
 	VoronoiSitePoints2D.clear();
-	VoronoiSitePoints2DVelocity.Empty();
+	VoronoiSiteWeights.clear();
+	LastWeightedSitePoints2D.clear();
+	VoronoiSiteMotion.resize(PlatformCount);
 	PlatformHeights.Empty();
 	
 	FVector BoundsCenter = VoronoiBounds.GetCenter();
@@ -207,147 +530,248 @@ void AMovingPlatformManager::GenerateRandomPoints()
 		// Random velocity
 		float VelX = GetRandomVelocityInRange(RandomStream);
 		float VelY = GetRandomVelocityInRange(RandomStream);
-		VoronoiSitePoints2DVelocity.Add({VelX, VelY});
+		VoronoiSiteMotion.vxs[i] = VelX;
+		VoronoiSiteMotion.vys[i] = VelY;
+
+		// The weight is the squared radius of the cell, relatively to the radius of the average cell
+		if (UseWeightedCells)
+		{
+			const double Size = RandomStream.FRandRange(MinCellSize, MaxCellSize);
+			VoronoiSiteWeights.push_back(Size * Size * BoundsExtent.X * BoundsExtent.Y * 4.0 / (PI * PlatformCount));
+		}
+	}
+	VoronoiSiteMotion.importPositions(VoronoiSitePoints2D);
+
+	RelaxationIterationsLeft = RelaxationIterations;
+	if (!RelaxOneIterationPerTick)
+	{
+		RelaxPoints(GetStepSettings());
 	}
 }
 
+void AMovingPlatformManager::RelaxPoints(const FVoronoiStepSettings& Settings)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VoronoiRelaxPoints);
+	TRACE_CPUPROFILER_EVENT_SCOPE(AMovingPlatformManager::RelaxPoints);
 
+	if (RelaxationIterationsLeft <= 0)
+	{
+		return;
+	}
 
-void AMovingPlatformManager::UpdateRandomPoints(float DeltaTime)
+	const int Iterations = Settings.RelaxOneIterationPerTick ? 1 : RelaxationIterationsLeft;
+	const bool Relaxed = VoronoiRelaxation.relax(VoronoiSitePoints2D, Settings.Bounds, Iterations, Settings.RelaxationTolerance);
+	VoronoiSiteMotion.importPositions(VoronoiSitePoints2D);
+	if (!Relaxed || VoronoiRelaxation.hasConverged(Settings.RelaxationTolerance))
+	{
+		RelaxationIterationsLeft = 0;
+		return;
+	}
+	RelaxationIterationsLeft -= Iterations;
+}
+
+
+
+void AMovingPlatformManager::UpdateRandomPoints(float DeltaTime, const FVoronoiStepSettings& Settings)
 {
-	for (int i = 0; i < PlatformCount; i++)
+	SCOPE_CYCLE_COUNTER(STAT_VoronoiUpdatePoints);
+	TRACE_CPUPROFILER_EVENT_SCOPE(AMovingPlatformManager::UpdateRandomPoints);
+
+	RelaxPoints(Settings);
+
+	// Several sites at a time without branches, split in chunks over the task graph when there are many
+	const int32 NumTasks = FMath::DivideAndRoundUp(Settings.NumSites, SitesPerTask);
+	ParallelFor(NumTasks, [this, DeltaTime, &Settings](int32 Task)
 	{
-		auto& Point = VoronoiSitePoints2D[i];
-		auto& Velocity = VoronoiSitePoints2DVelocity[i];
-		// Update position
-		Point += Velocity * DeltaTime;
+		VORONOI_ALLOCATION_SCOPE(NumStepAllocations);
+		const int32 Begin = Task * SitesPerTask;
+		integrateSiteMotion(VoronoiSiteMotion, DeltaTime, Settings.Bounds, Begin, FMath::Min(Begin + SitesPerTask, Settings.NumSites));
+	}, NumTasks > 1 ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+	VoronoiSiteMotion.exportPositions(VoronoiSitePoints2D);
+}
 
-		// Bounce off boundaries
-		if (Point.x <= VoronoiBounds.MinX || Point.x >= VoronoiBounds.MaxX)
-		{
-			Velocity.x = -Velocity.x;
-			Velocity.y = -Velocity.y;
-			Point.x = FMath::Clamp(Point.x, VoronoiBounds.MinX, VoronoiBounds.MaxX);
-		}
 
-		if (Point.y <= VoronoiBounds.MinY || Point.y >= VoronoiBounds.MaxY)
-		{
-			Velocity.x = -Velocity.x;
-			Velocity.y = -Velocity.y;
-			Point.y = FMath::Clamp(Point.y, VoronoiBounds.MinY, VoronoiBounds.MaxY);
-		}
+Box AMovingPlatformManager::GetVoronoiBox() const
+{
+	return Box{VoronoiBounds.MinX, VoronoiBounds.MinY, VoronoiBounds.MaxX, VoronoiBounds.MaxY};
+}
 
-		
-	}
+FVoronoiStepSettings AMovingPlatformManager::GetStepSettings() const
+{
+	FVoronoiStepSettings Settings;
+	Settings.NumSites = static_cast<int32>(VoronoiSitePoints2D.size());
+	Settings.Bounds = GetVoronoiBox();
+	Settings.UseKineticUpdate = UseKineticUpdate;
+	Settings.UseWeightedCells = UseWeightedCells && VoronoiSiteWeights.size() == VoronoiSitePoints2D.size();
+	Settings.RelaxOneIterationPerTick = RelaxOneIterationPerTick;
+	Settings.RelaxationTolerance = RelaxationTolerance;
+	return Settings;
 }
 
+void AMovingPlatformManager::UpdateStats(const FVoronoiFrame& Frame) const
+{
+	// Each cell has as many edges as corners
+	const int64 NumCellEdges = static_cast<int64>(Frame.Cells.points.size());
+	SET_DWORD_STAT(STAT_VoronoiSites, VoronoiSitePoints2D.size());
+	SET_DWORD_STAT(STAT_VoronoiCellEdges, NumCellEdges);
+	TRACE_COUNTER_SET(VoronoiSiteCount, static_cast<int64>(VoronoiSitePoints2D.size()));
+	TRACE_COUNTER_SET(VoronoiCellEdgeCount, NumCellEdges);
+
+	SET_MEMORY_STAT(STAT_VoronoiSitesMemory, GetAllocatedSize(VoronoiSitePoints2D) + GetAllocatedSize(VoronoiSiteWeights) +
+		GetAllocatedSize(LastWeightedSitePoints2D) + GetAllocatedSize(VoronoiSiteMotion.xs) + GetAllocatedSize(VoronoiSiteMotion.ys) +
+		GetAllocatedSize(VoronoiSiteMotion.vxs) + GetAllocatedSize(VoronoiSiteMotion.vys) + PlatformHeights.GetAllocatedSize());
+	SET_MEMORY_STAT(STAT_VoronoiDiagramMemory, GetAllocatedSize(VoronoiAlgorithm.getDiagram().getVertices()) +
+		GetAllocatedSize(VoronoiAlgorithm.getDiagram().getHalfEdges()));
+	SET_MEMORY_STAT(STAT_VoronoiCellsMemory, GetAllocatedSize(Frame.Cells.offsets) + GetAllocatedSize(Frame.Cells.points) +
+		GetAllocatedSize(Frame.Cells.vertices));
+	SET_MEMORY_STAT(STAT_VoronoiCellMetricsMemory, GetAllocatedSize(Frame.Metrics.areas) +
+		GetAllocatedSize(Frame.Metrics.centroids) + GetAllocatedSize(Frame.Metrics.perimeters) +
+		GetAllocatedSize(Frame.Metrics.bounds) + GetAllocatedSize(Frame.Metrics.radii));
+	SET_MEMORY_STAT(STAT_VoronoiPlatformTransformsMemory, Frame.Positions.GetAllocatedSize() + Frame.Radii.GetAllocatedSize());
+}
 
-void AMovingPlatformManager::GenerateVoronoiEdges()
+void AMovingPlatformManager::GenerateVoronoiEdges(const FVoronoiStepSettings& Settings, FVoronoiFrame& Frame)
 {
-	VoronoiEdges.Empty();
-	
-	FortuneAlgorithm algorithm(VoronoiSitePoints2D);
-	algorithm.construct();
-	const double MinX = VoronoiBounds.MinX;
-	const double MinY = VoronoiBounds.MinY;
-	const double MaxX = VoronoiBounds.MaxX;
-	const double MaxY = VoronoiBounds.MaxY;
-	algorithm.bound(Box{MinX-0.05, MinY-0.05, MaxX+0.05, MaxY+0.05});
-	VoronoiDiagram Diagram = algorithm.getDiagram();
-	Diagram.intersect(Box{MinX, MinY, MaxX, MaxY});
-	
-	VoronoiEdges.Init(TArray<TTuple<FVector, FVector>>(), PlatformCount);
+	SCOPE_CYCLE_COUNTER(STAT_VoronoiGenerateEdges);
+	TRACE_CPUPROFILER_EVENT_SCOPE(AMovingPlatformManager::GenerateVoronoiEdges);
 
-	for (std::size_t i = 0; i < PlatformCount; ++i)
+	// Power diagram of the weighted sites, it is built again every frame as cells may vanish or appear
+	if (Settings.UseWeightedCells)
 	{
-		const VoronoiDiagram::Site* site = Diagram.getSite(i);
-		Vector2 center = site->point;
-		VoronoiDiagram::Face* face = site->face;
-		VoronoiDiagram::HalfEdge* halfEdge = face->outerComponent;
-		if (halfEdge == nullptr)
-			continue;
-		while (halfEdge->prev != nullptr)
+		if (VoronoiKineticDiagram.build(VoronoiSitePoints2D, VoronoiSiteWeights))
 		{
-			halfEdge = halfEdge->prev;
-			if (halfEdge == face->outerComponent)
-				break;
+			LastWeightedSitePoints2D.assign(VoronoiSitePoints2D.begin(), VoronoiSitePoints2D.end());
+			VoronoiKineticDiagram.exportCells(Settings.Bounds, Frame.Cells);
+			Frame.Locator.build(VoronoiSitePoints2D, VoronoiSiteWeights);
+			return;
 		}
-		VoronoiDiagram::HalfEdge* start = halfEdge;
-		while (halfEdge != nullptr)
+
+		// The unweighted cells would change the sizes of the platforms, the last valid power diagram is shown instead
+		if (LastWeightedSitePoints2D.size() == VoronoiSitePoints2D.size() &&
+			VoronoiKineticDiagram.build(LastWeightedSitePoints2D, VoronoiSiteWeights))
 		{
-			if (halfEdge->origin != nullptr && halfEdge->destination != nullptr)
-			{
-				Vector2 _origin = (halfEdge->origin->point - center) + center;
-				FVector origin(_origin.x, _origin.y, 0);
-				Vector2 _destination = (halfEdge->destination->point - center) + center;
-				FVector destination(_destination.x, _destination.y, 0);
-				VoronoiEdges[i].Add(TTuple<FVector, FVector>(origin, destination));
-			}
-			halfEdge = halfEdge->next;
-			if (halfEdge == start)
-				break;
+			UE_LOG(LogTemp, Warning, TEXT("MovingPlatformManager: The power diagram of %d sites could not be built, the last valid one is kept"),
+				static_cast<int32>(VoronoiSitePoints2D.size()));
+			VoronoiKineticDiagram.exportCells(Settings.Bounds, Frame.Cells);
+			Frame.Locator.build(LastWeightedSitePoints2D, VoronoiSiteWeights);
+			return;
 		}
+		UE_LOG(LogTemp, Error, TEXT("MovingPlatformManager: The power diagram of %d sites could not be built, the cells are unweighted"),
+			static_cast<int32>(VoronoiSitePoints2D.size()));
 	}
-}
 
-void AMovingPlatformManager::InitializePlatformTransformData()
-{
-	GenerateRandomPoints();
-	GenerateVoronoiEdges();
+	// The sites moved a little since the last frame, the previous diagram is repaired with local flips
+	if (Settings.UseKineticUpdate && VoronoiKineticDiagram.update(VoronoiSitePoints2D))
+	{
+		VoronoiKineticDiagram.exportCells(Settings.Bounds, Frame.Cells);
+		Frame.Locator.build(VoronoiSitePoints2D);
+		return;
+	}
 
-	GeneratePlatformPositions();
-	GeneratePlatformRadii();
+	// The context is reused every frame so that its buffers are not reallocated
+	VoronoiAlgorithm.reset(VoronoiSitePoints2D);
+	VoronoiAlgorithm.setTriangulationEnabled(Settings.UseKineticUpdate);
+	VoronoiAlgorithm.construct();
+	// If the triangulation is incomplete the kinetic diagram is left empty, the next frame sweeps again
+	if (Settings.UseKineticUpdate)
+		VoronoiKineticDiagram.build(VoronoiAlgorithm);
+	VoronoiAlgorithm.clip(Settings.Bounds);
+	VoronoiAlgorithm.getDiagram().exportCells(Frame.Cells);
+	Frame.Locator.build(VoronoiAlgorithm.getDiagram());
 }
 
-void AMovingPlatformManager::UpdatePlatformTransformData(float DeltaTime)
+int32 AMovingPlatformManager::FindPlatformAt(const FVector& WorldPosition, int32 Hint) const
 {
-	UpdateRandomPoints(DeltaTime);
-	GenerateVoronoiEdges();
+	// INDEX_NONE becomes an invalid hint, the locator then searches its grid
+	const FVector Position = WorldPosition - GetActorLocation();
+	const PointLocator::Index Site = VoronoiFrames[CurrentVoronoiFrame].Locator.locate(Vector2(Position.X, Position.Y), static_cast<PointLocator::Index>(Hint));
+	return Site == VoronoiDiagram::INVALID_INDEX ? INDEX_NONE : static_cast<int32>(Site);
+}
 
-	GeneratePlatformPositions();
-	GeneratePlatformRadii();
+void AMovingPlatformManager::FindNearestPlatforms(const FVector& WorldPosition, int32 Count, TArray<int32>& OutPlatforms) const
+{
+	const FVector Position = WorldPosition - GetActorLocation();
+	std::vector<PointLocator::Index> Sites;
+	VoronoiFrames[CurrentVoronoiFrame].Locator.findNearest(Vector2(Position.X, Position.Y), FMath::Max(Count, 0), Sites);
+	OutPlatforms.SetNumUninitialized(Sites.size());
+	for (int32 i = 0; i < OutPlatforms.Num(); i++)
+	{
+		OutPlatforms[i] = static_cast<int32>(Sites[i]);
+	}
 }
 
+void AMovingPlatformManager::FindPlatformsInRadius(const FVector& WorldPosition, float Radius, TArray<int32>& OutPlatforms) const
+{
+	const FVector Position = WorldPosition - GetActorLocation();
+	std::vector<PointLocator::Index> Sites;
+	VoronoiFrames[CurrentVoronoiFrame].Locator.findInRadius(Vector2(Position.X, Position.Y), Radius, Sites);
+	OutPlatforms.SetNumUninitialized(Sites.size());
+	for (int32 i = 0; i < OutPlatforms.Num(); i++)
+	{
+		OutPlatforms[i] = static_cast<int32>(Sites[i]);
+	}
+}
 
-void AMovingPlatformManager::GeneratePlatformPositions()
+void AMovingPlatformManager::InitializePlatformTransformData()
 {
+	// The platforms are placed at once on the first frame
+	CancelVoronoiTask();
+	PendingDeltaTime = 0.0f;
+	NumTransformDataUpdates = 0;
 	PlatformPositions.Empty();
-	
-	for (int i = 0; i < PlatformCount; i++)
+	PlatformRadii.Empty();
+
+	FVoronoiFrame& Frame = VoronoiFrames[1 - CurrentVoronoiFrame];
+	GenerateRandomPoints();
+	const FVoronoiStepSettings Settings = GetStepSettings();
+	GenerateVoronoiEdges(Settings, Frame);
+
+	GeneratePlatformPositionsAndRadii(Settings, Frame);
+	PublishVoronoiFrame(false);
+}
+
+void AMovingPlatformManager::UpdatePlatformTransformData(float DeltaTime, const FVoronoiStepSettings& Settings, FVoronoiFrame& Frame)
+{
+	// Run by the background task when ComputeAsynchronously is set, it only writes Frame and the state of the sites
+	NumTransformDataUpdates++;
+	UpdateRandomPoints(DeltaTime, Settings);
+	if (VoronoiTaskCancelled)
 	{
-		const auto& EdgesPerSite = VoronoiEdges[i];
-		float Area = 0;
-		float CenterX = 0;
-		float CenterY = 0;
-		for (const auto& Edge : EdgesPerSite)
-		{
-			float Value = Edge.Get<0>().X * Edge.Get<1>().Y - Edge.Get<1>().X * Edge.Get<0>().Y;
-			CenterX += (Edge.Get<0>().X + Edge.Get<1>().X) * Value;
-			CenterY += (Edge.Get<0>().Y + Edge.Get<1>().Y) * Value;
-			Area += Edge.Get<0>().X * Edge.Get<1>().Y - Edge.Get<1>().X * Edge.Get<0>().Y;
-		}
-		// Area *= 0.5;
-		CenterX /= 3.0 * Area;
-		CenterY /= 3.0 * Area;
-		PlatformPositions.Add(FVector(CenterX, CenterY, PlatformHeights[i]));
-		
-		// UE_LOG(LogTemp, Warning, TEXT("PlatformPositions at (%f, %f)"), CenterX, CenterY);
+		return;
+	}
+	GenerateVoronoiEdges(Settings, Frame);
+	if (VoronoiTaskCancelled)
+	{
+		return;
 	}
+
+	GeneratePlatformPositionsAndRadii(Settings, Frame);
+	UpdateStats(Frame);
 }
 
-void AMovingPlatformManager::GeneratePlatformRadii()
+
+void AMovingPlatformManager::GeneratePlatformPositionsAndRadii(const FVoronoiStepSettings& Settings, FVoronoiFrame& Frame)
 {
-	PlatformRadii.Empty();
-	
-	for (int i = 0; i < PlatformCount; i++)
+	SCOPE_CYCLE_COUNTER(STAT_VoronoiPositionsAndRadii);
+	TRACE_CPUPROFILER_EVENT_SCOPE(AMovingPlatformManager::GeneratePlatformPositionsAndRadii);
+
+	// The cells are measured in one pass, split in chunks over the task graph when there are many
+	const int32 NumTasks = FMath::DivideAndRoundUp(Settings.NumSites, CellsPerTask);
+	Frame.Metrics.resize(Settings.NumSites);
+	ParallelFor(NumTasks, [this, &Frame, &Settings](int32 Task)
 	{
-		TArray<TTuple<FVector, FVector>>& SiteEdges = VoronoiEdges[i];
-		const FVector CenterPos = FVector(PlatformPositions[i].X, PlatformPositions[i].Y, 0);
-		float MinDistance = MAX_FLT;	// Distance from the center to the closest edge
-		for (const auto& edge : SiteEdges)
-		{
-			MinDistance = std::min(MinDistance, UKismetMathLibrary::GetPointDistanceToSegment(CenterPos, edge.Get<0>(), edge.Get<1>()));
-		}
-		PlatformRadii.Add(MinDistance);
+		VORONOI_ALLOCATION_SCOPE(NumStepAllocations);
+		const int32 Begin = Task * CellsPerTask;
+		computeCellMetrics(Frame.Cells, Begin, FMath::Min(Begin + CellsPerTask, Settings.NumSites), Frame.Metrics);
+	}, NumTasks > 1 ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+	Frame.Positions.SetNumUninitialized(Settings.NumSites);
+	Frame.Radii.SetNumUninitialized(Settings.NumSites);
+	for (int i = 0; i < Settings.NumSites; i++)
+	{
+		// The cell of a weighted site may be empty
+		const Vector2& Center = Frame.Metrics.areas[i] > 0 ? Frame.Metrics.centroids[i] : VoronoiSitePoints2D[i];
+		Frame.Positions[i] = FVector(Center.x, Center.y, PlatformHeights[i]);
+		Frame.Radii[i] = Frame.Metrics.radii[i];
 	}
 }
@@ -0,0 +1,98 @@
+#include "VoronoiAllocationCounter.h"
+
+#if VORONOI_COUNT_ALLOCATIONS
+
+#include "HAL/MemoryBase.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+namespace
+{
+	bool CountingMallocInstalled = false;
+
+	// Of the innermost scope open on the calling thread
+	thread_local std::atomic<int32>* CurrentCounter = nullptr;
+
+	// Forwards everything to the allocator it wraps, the blocks can be freed by either of them
+	class FVoronoiCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FVoronoiCountingMalloc(FMalloc* InInnerMalloc) : InnerMalloc(InInnerMalloc) {}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return InnerMalloc->Malloc(Count, Alignment);
+		}
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return InnerMalloc->TryMalloc(Count, Alignment);
+		}
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return InnerMalloc->Realloc(Original, Count, Alignment);
+		}
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return InnerMalloc->TryRealloc(Original, Count, Alignment);
+		}
+		virtual void Free(void* Original) override { InnerMalloc->Free(Original); }
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return InnerMalloc->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return InnerMalloc->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { InnerMalloc->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { InnerMalloc->SetupTLSCachesOnCurrentThread(); }
+		virtual void MarkTLSCachesAsUsedOnCurrentThread() override { InnerMalloc->MarkTLSCachesAsUsedOnCurrentThread(); }
+		virtual void MarkTLSCachesAsUnusedOnCurrentThread() override { InnerMalloc->MarkTLSCachesAsUnusedOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void UpdateStats() override { InnerMalloc->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { InnerMalloc->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { InnerMalloc->DumpAllocatorStats(Ar); }
+		virtual bool IsInternallyThreadSafe() const override { return InnerMalloc->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return InnerMalloc->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return InnerMalloc->GetDescriptiveName(); }
+
+	private:
+		static void CountAllocation()
+		{
+			if (std::atomic<int32>* Counter = CurrentCounter)
+			{
+				Counter->fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		FMalloc* InnerMalloc;
+	};
+}
+
+void InstallVoronoiCountingMalloc()
+{
+	check(IsInGameThread());
+	if (CountingMallocInstalled || !FParse::Param(FCommandLine::Get(), TEXT("VoronoiCheckTickAllocations")))
+	{
+		return;
+	}
+
+	// The task graph threads are already allocating. They see either the previous allocator, which stays valid and frees
+	// the blocks of the proxy as it only forwards to it, or the proxy once it is fully constructed, as the exchange is a
+	// full barrier. The proxy is never removed.
+	FMalloc* Proxy = new FVoronoiCountingMalloc(GMalloc);
+	FPlatformAtomics::InterlockedExchangePtr(reinterpret_cast<void**>(&GMalloc), Proxy);
+	CountingMallocInstalled = true;
+}
+
+FVoronoiAllocationScope::FVoronoiAllocationScope(std::atomic<int32>& Counter)
+	: PreviousCounter(CurrentCounter)
+{
+	CurrentCounter = &Counter;
+}
+
+FVoronoiAllocationScope::~FVoronoiAllocationScope()
+{
+	CurrentCounter = PreviousCounter;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+// Heap allocations are only counted in development builds, on the platforms that call GMalloc through its interface
+#define VORONOI_COUNT_ALLOCATIONS (!UE_BUILD_SHIPPING && !PLATFORM_USES_FIXED_GMalloc_CLASS)
+
+#if VORONOI_COUNT_ALLOCATIONS
+
+// Wraps GMalloc in a counting proxy if the game is started with -VoronoiCheckTickAllocations, like the proxies that the
+// engine installs from the command line. Called once by the game module at startup, before any platform ticks.
+void InstallVoronoiCountingMalloc();
+
+// Counts the heap allocations made by the calling thread into Counter while the scope is alive, to check that the
+// steady-state ticks of the platforms do not allocate. The scopes of several threads can share a counter, the tasks and
+// the ParallelFor bodies open their own scope on the counter of the tick that launched them. Counter stays at 0 unless
+// the counting proxy is installed.
+class FVoronoiAllocationScope
+{
+public:
+	explicit FVoronoiAllocationScope(std::atomic<int32>& Counter);
+	~FVoronoiAllocationScope();
+
+private:
+	std::atomic<int32>* PreviousCounter;	// Of the scope it is nested in on this thread
+};
+
+#define VORONOI_ALLOCATION_SCOPE(Counter) FVoronoiAllocationScope ANONYMOUS_VARIABLE(VoronoiAllocationScope)(Counter)
+
+#else
+
+#define VORONOI_ALLOCATION_SCOPE(Counter)
+
+#endif
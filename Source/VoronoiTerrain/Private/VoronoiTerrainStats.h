@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+// Per-frame breakdown of the platform pipeline, shown with "stat VoronoiTerrain" and in Unreal Insights
+DECLARE_STATS_GROUP(TEXT("VoronoiTerrain"), STATGROUP_VoronoiTerrain, STATCAT_Advanced);
+
+// Stages of AMovingPlatformManager::Tick
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Manager Tick"), STAT_VoronoiManagerTick, STATGROUP_VoronoiTerrain, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Points"), STAT_VoronoiUpdatePoints, STATGROUP_VoronoiTerrain, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Relax Points"), STAT_VoronoiRelaxPoints, STATGROUP_VoronoiTerrain, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Generate Edges"), STAT_VoronoiGenerateEdges, STATGROUP_VoronoiTerrain, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Positions And Radii"), STAT_VoronoiPositionsAndRadii, STATGROUP_VoronoiTerrain, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Platforms"), STAT_VoronoiUpdatePlatforms, STATGROUP_VoronoiTerrain, );
+
+// Sizes of the current frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Sites"), STAT_VoronoiSites, STATGROUP_VoronoiTerrain, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cell Edges"), STAT_VoronoiCellEdges, STATGROUP_VoronoiTerrain, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Components Updated"), STAT_VoronoiComponentsUpdated, STATGROUP_VoronoiTerrain, );
+
+// Memory held by each stage, capacities included as the buffers are reused between frames
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Sites Memory"), STAT_VoronoiSitesMemory, STATGROUP_VoronoiTerrain, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Diagram Memory"), STAT_VoronoiDiagramMemory, STATGROUP_VoronoiTerrain, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Cells Memory"), STAT_VoronoiCellsMemory, STATGROUP_VoronoiTerrain, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Cell Metrics Memory"), STAT_VoronoiCellMetricsMemory, STATGROUP_VoronoiTerrain, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Platform Transforms Memory"), STAT_VoronoiPlatformTransformsMemory, STATGROUP_VoronoiTerrain, );
+
+// Same sizes as trace counters, to line them up with the CPU timeline in Insights
+TRACE_DECLARE_INT_COUNTER_EXTERN(VoronoiSiteCount);
+TRACE_DECLARE_INT_COUNTER_EXTERN(VoronoiCellEdgeCount);
+TRACE_DECLARE_INT_COUNTER_EXTERN(VoronoiComponentsUpdated);
@@ -5,7 +5,8 @@
 #include "MovingPlatformComponent.generated.h"
 
 /**
- * 
+ * Platform moved by AMovingPlatformManager, it does not tick: the manager pushes the transforms of all the platforms
+ * after each update of the diagram
  */
 UCLASS()
 class VORONOITERRAIN_API UMovingPlatformComponent : public UStaticMeshComponent
@@ -23,17 +24,10 @@ protected:
 	UPROPERTY()
 	int PlatformIndex;
 
-	UPROPERTY()
-	FVector TargetPosition;
-
-	UPROPERTY()
-	float TargetScale;
-
 public:
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
-	
 	void InitializePlatform(int InPlatformIndex, const FVector& InitialPosition, float InitialScale = 1.0f);
-	void UpdatePlatformData(const FVector& NewPosition, float NewScale);
+	// Return false if the platform is already within Tolerance of the transform, it is then left untouched
+	bool UpdatePlatformTransform(const FTransform& NewTransform, float Tolerance);
 
 	int GetPlatformIndex() const { return PlatformIndex; }
 };
@@ -1,15 +1,45 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include <atomic>
 #include "GameFramework/Actor.h"
+#include "Components/InstancedStaticMeshComponent.h"
 #include "Engine/StaticMesh.h"
 #include "Materials/Material.h"
+#include "Tasks/Task.h"
 #include "MovingPlatformComponent.h"
+#include "FortuneAlgorithm/CellMetrics.h"
 #include "FortuneAlgorithm/FortuneAlgorithm.h"
+#include "FortuneAlgorithm/KineticDiagram.h"
+#include "FortuneAlgorithm/LloydRelaxation.h"
+#include "FortuneAlgorithm/PointLocator.h"
+#include "FortuneAlgorithm/SiteMotion.h"
 #include "MovingPlatformManager.generated.h"
 
 class FVoronoiDiagram;
 
+// Output of one step of the pipeline, the background task fills one frame while the game thread reads the other
+struct FVoronoiFrame
+{
+	VoronoiDiagram::Cells Cells;	// Polygons of the cells, flat and indexed by site
+	PointLocator Locator;	// Rebuilt with the cells
+	CellMetrics Metrics;	// Area, centroid, perimeter, bounds and inscribed radius of each cell
+	TArray<FVector> Positions;
+	TArray<float> Radii;
+};
+
+// Properties read by one step of the pipeline, copied when the step starts so that they can be changed while the
+// background task runs
+struct FVoronoiStepSettings
+{
+	int32 NumSites = 0;	// Generated by GenerateRandomPoints, PlatformCount may have changed since
+	Box Bounds{};
+	bool UseKineticUpdate = false;
+	bool UseWeightedCells = false;	// Only if the sites were generated with their weights
+	bool RelaxOneIterationPerTick = false;
+	float RelaxationTolerance = 0.0f;
+};
+
 USTRUCT()
 struct FVoronoiBounds
 {
@@ -48,12 +78,20 @@ protected:
 
 	virtual void OnConstruction(const FTransform& Transform) override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void PreEditChange(FProperty* PropertyAboutToChange) override;
+
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 
-	void SetupPlatformAppearance(UMovingPlatformComponent* Platform);
+	void SetupPlatformAppearance(UStaticMeshComponent* Platform);
 	
 	UPROPERTY()
 	TArray<UMovingPlatformComponent*> PlatformComponents;
+
+	// All the platforms when UseInstancedPlatforms is set, instance i is platform i
+	UPROPERTY()
+	UInstancedStaticMeshComponent* PlatformInstances = nullptr;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Moving Platform Manager", meta = (ClampMin = "0"))
 	int PlatformCount = 5;
@@ -64,6 +102,15 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Moving Platform Manager")
 	UMaterial* PlatformMaterial;
 
+	// Draw the platforms as instances of one component instead of one component each,
+	// their transforms are pushed in one batch per frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Moving Platform Manager")
+	bool UseInstancedPlatforms = false;
+
+	// Platforms whose transform changed less than this are not moved
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Moving Platform Manager", meta = (ClampMin = "0"))
+	float PlatformMoveTolerance = 0.01f;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Moving Platform Manager")
 	float MinHeight = 0.0f;
 	
@@ -82,6 +129,50 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voronoi Generation")
 	int RandomSeed = 10;
 
+	// Repair the previous diagram with local edge flips instead of running Fortune's algorithm every frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voronoi Generation")
+	bool UseKineticUpdate = false;
+
+	// Give each cell a random weight and build the power diagram, so that the platforms have different sizes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voronoi Generation")
+	bool UseWeightedCells = false;
+
+	// Range of the size of the weighted cells, relatively to the size of the cells without weights
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voronoi Generation", meta = (ClampMin = "0", EditCondition = "UseWeightedCells"))
+	float MinCellSize = 0.5f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voronoi Generation", meta = (ClampMin = "0", EditCondition = "UseWeightedCells"))
+	float MaxCellSize = 1.5f;
+
+	// Lloyd iterations moving the sites to the centroids of their cells, for evenly sized platforms
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voronoi Generation", meta = (ClampMin = "0"))
+	int RelaxationIterations = 0;
+
+	// The relaxation stops when no site moves more than this distance
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voronoi Generation", meta = (ClampMin = "0"))
+	float RelaxationTolerance = 0.1f;
+
+	// Spread the iterations over the ticks instead of running them all when the points are generated
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voronoi Generation")
+	bool RelaxOneIterationPerTick = false;
+
+	// Move the sites and build the diagram on a background task, the platforms are interpolated towards the last
+	// completed frame so that the game thread never waits for the diagram
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voronoi Generation")
+	bool ComputeAsynchronously = true;
+
+	// Move the sites at a fixed rate whatever the frame rate, the platforms are interpolated between the last two states
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voronoi Generation")
+	bool UseFixedTimestep = false;
+
+	// Simulation steps per second
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voronoi Generation", meta = (ClampMin = "1", EditCondition = "UseFixedTimestep"))
+	float SimulationRate = 30.0f;
+
+	// Steps run in one tick at most, a longer frame drops the time it cannot catch up
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voronoi Generation", meta = (ClampMin = "1", EditCondition = "UseFixedTimestep"))
+	int MaxSubsteps = 4;
+
 	UPROPERTY(EditAnywhere, Category="Debug")
 	bool ShowDebugEdges = false;
 
@@ -97,21 +188,69 @@ public:
 	
 	// Compute Voronoi Diagram Using Fortune Algorithm //
 	void GenerateRandomPoints();	// Write VoronoiSitePoints
-	void UpdateRandomPoints(float DeltaTime);
-	void GenerateVoronoiEdges();	// Write VoronoiEdges
+	void UpdateRandomPoints(float DeltaTime, const FVoronoiStepSettings& Settings);
+	void RelaxPoints(const FVoronoiStepSettings& Settings);	// Move VoronoiSitePoints2D to the centroids of their cells
+	void GenerateVoronoiEdges(const FVoronoiStepSettings& Settings, FVoronoiFrame& Frame);	// Write the cells and the locator of the frame
 	void InitializePlatformTransformData();
-	void UpdatePlatformTransformData(float DeltaTime);
+	void UpdatePlatformTransformData(float DeltaTime, const FVoronoiStepSettings& Settings, FVoronoiFrame& Frame);
 	float GetRandomVelocityInRange(const FRandomStream RandomStream) const;
 	
-	void GeneratePlatformPositions();
-	void GeneratePlatformRadii();
+	void GeneratePlatformPositionsAndRadii(const FVoronoiStepSettings& Settings, FVoronoiFrame& Frame);	// From the centroids and the inscribed radii of the cells
 
+	// Transforms shown this tick, interpolated towards the ones of the current frame
 	TArray<FVector> PlatformPositions;
 	TArray<float> PlatformRadii;
 
+	// Spatial queries on the cells of the current frame, safe to call from several threads at once outside of Tick
+	// Platform whose cell contains the position, pass the result of the previous frame as hint to walk from its cell
+	int32 FindPlatformAt(const FVector& WorldPosition, int32 Hint = INDEX_NONE) const;
+	// Platforms closest to the position, by increasing distance
+	void FindNearestPlatforms(const FVector& WorldPosition, int32 Count, TArray<int32>& OutPlatforms) const;
+	void FindPlatformsInRadius(const FVector& WorldPosition, float Radius, TArray<int32>& OutPlatforms) const;
+
 private:
-	std::vector<Vector2> VoronoiSitePoints2D;
+	Box GetVoronoiBox() const;
+	FVoronoiStepSettings GetStepSettings() const;	// Of the sites generated last
+	FVector GetPlatformMeshSize() const;
+	FTransform GetPlatformTransform(int32 Platform, const FVector& MeshSize) const;	// In world space
+	void CreatePlatformInstances();
+	void UpdatePlatformInstances();
+	void UpdateStats(const FVoronoiFrame& Frame) const;	// Sizes and memory of the pipeline, for "stat VoronoiTerrain" and Insights
+
+	// Steps of the simulation, they return how far the platforms are between the interpolated states
+	float StepSynchronously();
+	float StepAsynchronously(float DeltaTime);
+	float GetFixedTimestep() const;
+	int32 ConsumeFixedSteps();	// Steps due in PendingDeltaTime, at most MaxSubsteps
+
+	// Double buffering, the task owns the sites and the diagram contexts while it is in flight
+	void LaunchVoronoiTask();
+	void CancelVoronoiTask();	// Wait for the task in flight and drop its frame
+	void PublishVoronoiFrame(bool StartFromPreviousFrame);	// Make the other frame current
+	void CheckStepAllocations(int32 NumPlatforms);	// Made since the last frame was published, with -VoronoiCheckTickAllocations
+	void InterpolatePlatformTransforms(float Alpha);
+
+	FortuneAlgorithm VoronoiAlgorithm;
+	KineticDiagram VoronoiKineticDiagram;
+	LloydRelaxation VoronoiRelaxation;
+	int RelaxationIterationsLeft = 0;	// When the iterations are spread over the ticks
+	std::vector<Vector2> VoronoiSitePoints2D;	// Exported from VoronoiSiteMotion for the diagram
+	std::vector<double> VoronoiSiteWeights;	// Only with UseWeightedCells
+	std::vector<Vector2> LastWeightedSitePoints2D;	// Of the last power diagram built, its cells are kept when a build fails
 	TArray<float> PlatformHeights;
-	TArray<TArray<TTuple<FVector, FVector>>> VoronoiEdges;
-	TArray<Vector2> VoronoiSitePoints2DVelocity;
+	SiteMotion VoronoiSiteMotion;	// Positions and velocities of the sites, in separate arrays
+	TArray<FTransform> PlatformInstanceTransforms;	// Kept between frames for the batched update
+
+	FVoronoiFrame VoronoiFrames[2];
+	int32 CurrentVoronoiFrame = 0;	// Read by the game thread, the task writes the other one
+	UE::Tasks::FTask VoronoiTask;
+	std::atomic<bool> VoronoiTaskCancelled{false};
+	float VoronoiTaskDeltaTime = 0.0f;	// Time simulated by the task in flight
+	float PendingDeltaTime = 0.0f;	// Elapsed time not simulated yet
+	int32 NumTransformDataUpdates = 0;	// Since InitializePlatformTransformData, the later ones do not allocate while ParallelFor runs inline
+	std::atomic<int32> NumStepAllocations{0};	// By the game thread and the task since the last frame was published
+	TArray<FVector> InterpolationStartPositions;
+	TArray<float> InterpolationStartRadii;
+	float InterpolationTime = 0.0f;	// Since the last frame of the task was published
+	float InterpolationDuration = 0.0f;
 };
@@ -1,7 +1,20 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "VoronoiTerrain.h"
+#include "VoronoiAllocationCounter.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, VoronoiTerrain, "VoronoiTerrain" );
+class FVoronoiTerrainModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+#if VORONOI_COUNT_ALLOCATIONS
+		// Before any platform manager ticks
+		InstallVoronoiCountingMalloc();
+#endif
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FVoronoiTerrainModule, VoronoiTerrain, "VoronoiTerrain" );
  
\ No newline at end of file
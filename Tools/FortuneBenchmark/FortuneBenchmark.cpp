@@ -0,0 +1,667 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <numbers>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+// System
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+// My includes
+#include "CellMetrics.h"
+#include "FortuneAlgorithm.h"
+#include "PointLocator.h"
+#include "SimdKernels.h"
+#include "SiteMotion.h"
+
+// Cost of each phase of the pipeline used by the terrain, per site, over sizes and distributions of sites:
+// reset, construct, clip to the unit square, exportCells and computeCellMetrics.
+// The cells must cover the box exactly, the grid is the most degenerate case with four cocircular sites around each vertex.
+// With --steady-frames, the sites also move for that many frames as on the terrain, and the program fails if a frame
+// after the first one allocates.
+// Usage: FortuneBenchmark [--min-sites n] [--max-sites n] [--threads n] [--seed n] [--json path] [--steady-frames n]
+
+// Allocations
+
+namespace
+{
+    // Each block is prefixed with its size to know how many bytes are released
+    constexpr std::size_t HEADER_SIZE = alignof(std::max_align_t);
+
+    std::atomic<std::size_t> gNbAllocations{0};
+    std::atomic<std::size_t> gNbAllocatedBytes{0};
+    std::atomic<std::size_t> gCurrentBytes{0};
+    std::atomic<std::size_t> gPeakBytes{0};
+
+    void* allocate(std::size_t size) noexcept
+    {
+        auto block = static_cast<unsigned char*>(std::malloc(size + HEADER_SIZE));
+        if (block == nullptr)
+            return nullptr;
+        std::memcpy(block, &size, sizeof(size));
+        gNbAllocations.fetch_add(1, std::memory_order_relaxed);
+        gNbAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        std::size_t current = gCurrentBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        std::size_t peak = gPeakBytes.load(std::memory_order_relaxed);
+        while (current > peak && !gPeakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed))
+            ;
+        return block + HEADER_SIZE;
+    }
+
+    void deallocate(void* ptr) noexcept
+    {
+        if (ptr == nullptr)
+            return;
+        auto block = static_cast<unsigned char*>(ptr) - HEADER_SIZE;
+        std::size_t size;
+        std::memcpy(&size, block, sizeof(size));
+        gCurrentBytes.fetch_sub(size, std::memory_order_relaxed);
+        std::free(block);
+    }
+
+    void* allocateOrThrow(std::size_t size)
+    {
+        void* ptr = allocate(size);
+        if (ptr == nullptr)
+            throw std::bad_alloc();
+        return ptr;
+    }
+}
+
+void* operator new(std::size_t size) { return allocateOrThrow(size); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void operator delete(void* ptr) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { deallocate(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { deallocate(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { deallocate(ptr); }
+
+namespace
+{
+    struct AllocationCounter
+    {
+        std::size_t nbAllocations;
+        std::size_t nbBytes;
+
+        static AllocationCounter now()
+        {
+            return AllocationCounter{gNbAllocations.load(), gNbAllocatedBytes.load()};
+        }
+
+        AllocationCounter operator-(const AllocationCounter& other) const
+        {
+            return AllocationCounter{nbAllocations - other.nbAllocations, nbBytes - other.nbBytes};
+        }
+    };
+
+    // Peak resident set size of the process since its start, in bytes
+    std::size_t getPeakRss()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0;
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+#if defined(__APPLE__)
+        return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+        return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+
+    // Distributions of sites in the unit square
+
+    enum class Distribution {UNIFORM, CLUSTERED, GRID, POISSON_DISK};
+    constexpr std::array<Distribution, 4> DISTRIBUTIONS = {Distribution::UNIFORM, Distribution::CLUSTERED,
+        Distribution::GRID, Distribution::POISSON_DISK};
+
+    const char* getName(Distribution distribution)
+    {
+        switch (distribution)
+        {
+            case Distribution::UNIFORM:
+                return "uniform";
+            case Distribution::CLUSTERED:
+                return "clustered";
+            case Distribution::GRID:
+                return "grid";
+            case Distribution::POISSON_DISK:
+                return "poisson-disk";
+        }
+        return "";
+    }
+
+    std::vector<Vector2> generateUniform(std::size_t nbSites, std::mt19937_64& generator)
+    {
+        std::uniform_real_distribution<double> distribution(0.0, 1.0);
+        std::vector<Vector2> points(nbSites);
+        for (auto& point : points)
+            point = Vector2(distribution(generator), distribution(generator));
+        return points;
+    }
+
+    // Gaussian clusters of about 1000 sites, the samples outside of the square are drawn again
+    std::vector<Vector2> generateClustered(std::size_t nbSites, std::mt19937_64& generator)
+    {
+        std::size_t nbClusters = 1 + nbSites / 1000;
+        std::vector<Vector2> centers = generateUniform(nbClusters, generator);
+        std::uniform_int_distribution<std::size_t> clusterDistribution(0, nbClusters - 1);
+        std::normal_distribution<double> offsetDistribution(0.0, 0.25 / std::sqrt(static_cast<double>(nbClusters)));
+        std::vector<Vector2> points;
+        points.reserve(nbSites);
+        while (points.size() < nbSites)
+        {
+            Vector2 point = centers[clusterDistribution(generator)] +
+                Vector2(offsetDistribution(generator), offsetDistribution(generator));
+            if (point.x >= 0.0 && point.x <= 1.0 && point.y >= 0.0 && point.y <= 1.0)
+                points.push_back(point);
+        }
+        return points;
+    }
+
+    // Square lattice with a partial top row: many cocircular sites and Voronoi vertices on the sides of the box
+    std::vector<Vector2> generateGrid(std::size_t nbSites)
+    {
+        std::size_t side = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(nbSites))));
+        double step = 1.0 / static_cast<double>(side);
+        std::vector<Vector2> points(nbSites);
+        for (std::size_t i = 0; i < nbSites; ++i)
+            points[i] = Vector2((static_cast<double>(i % side) + 0.5) * step, (static_cast<double>(i / side) + 0.5) * step);
+        return points;
+    }
+
+    // Bridson's sampling with a radius chosen to get about nbSites sites, the actual number is reported
+    std::vector<Vector2> generatePoissonDisk(std::size_t nbSites, std::mt19937_64& generator)
+    {
+        constexpr int NB_CANDIDATES = 30;
+        constexpr std::uint32_t EMPTY = std::numeric_limits<std::uint32_t>::max();
+        double radius = std::sqrt(0.7 / static_cast<double>(nbSites));
+        double cellSize = radius / std::sqrt(2.0);
+        std::size_t gridSize = static_cast<std::size_t>(std::ceil(1.0 / cellSize));
+        std::vector<std::uint32_t> grid(gridSize * gridSize, EMPTY);
+        auto getCell = [&](double x)
+        {
+            return std::min(static_cast<std::size_t>(x / cellSize), gridSize - 1);
+        };
+        std::uniform_real_distribution<double> distribution(0.0, 1.0);
+        std::vector<Vector2> points;
+        std::vector<std::uint32_t> active;
+        auto addPoint = [&](const Vector2& point)
+        {
+            grid[getCell(point.y) * gridSize + getCell(point.x)] = static_cast<std::uint32_t>(points.size());
+            active.push_back(static_cast<std::uint32_t>(points.size()));
+            points.push_back(point);
+        };
+        addPoint(Vector2(distribution(generator), distribution(generator)));
+        while (!active.empty())
+        {
+            std::size_t i = std::uniform_int_distribution<std::size_t>(0, active.size() - 1)(generator);
+            Vector2 origin = points[active[i]];
+            bool isFound = false;
+            for (int j = 0; j < NB_CANDIDATES && !isFound; ++j)
+            {
+                double angle = 2.0 * std::numbers::pi * distribution(generator);
+                double distance = radius * (1.0 + distribution(generator));
+                Vector2 candidate = origin + distance * Vector2(std::cos(angle), std::sin(angle));
+                if (candidate.x < 0.0 || candidate.x > 1.0 || candidate.y < 0.0 || candidate.y > 1.0)
+                    continue;
+                std::size_t column = getCell(candidate.x);
+                std::size_t row = getCell(candidate.y);
+                isFound = true;
+                for (std::size_t y = row - std::min<std::size_t>(row, 2); y <= std::min(row + 2, gridSize - 1) && isFound; ++y)
+                {
+                    for (std::size_t x = column - std::min<std::size_t>(column, 2); x <= std::min(column + 2, gridSize - 1); ++x)
+                    {
+                        std::uint32_t neighbor = grid[y * gridSize + x];
+                        if (neighbor != EMPTY && (points[neighbor] - candidate).getNorm() < radius)
+                        {
+                            isFound = false;
+                            break;
+                        }
+                    }
+                }
+                if (isFound)
+                    addPoint(candidate);
+            }
+            if (!isFound)
+            {
+                active[i] = active.back();
+                active.pop_back();
+            }
+        }
+        return points;
+    }
+
+    std::vector<Vector2> generatePoints(Distribution distribution, std::size_t nbSites, std::mt19937_64& generator)
+    {
+        switch (distribution)
+        {
+            case Distribution::UNIFORM:
+                return generateUniform(nbSites, generator);
+            case Distribution::CLUSTERED:
+                return generateClustered(nbSites, generator);
+            case Distribution::GRID:
+                return generateGrid(nbSites);
+            case Distribution::POISSON_DISK:
+                return generatePoissonDisk(nbSites, generator);
+        }
+        return {};
+    }
+
+    // Pipeline
+
+    enum Phase {RESET, CONSTRUCT, CLIP, EXPORT, METRICS, NB_PHASES};
+    constexpr std::array<const char*, NB_PHASES> PHASE_NAMES = {"reset", "construct", "clip", "export", "metrics"};
+    constexpr std::size_t SITES_PER_CASE = 2000000; // Minimum number of sites processed by the warm runs of a case
+    constexpr std::size_t MAX_NB_RUNS = 100000;
+
+    struct Pipeline
+    {
+        FortuneAlgorithm algorithm;
+        VoronoiDiagram::Cells cells;
+        CellMetrics metrics;
+    };
+
+    struct Result
+    {
+        Distribution distribution;
+        std::size_t nbRequestedSites;
+        std::size_t nbSites;
+        std::size_t nbRuns;
+        bool isClipped;
+        bool isCovered; // The areas of the cells add up to the area of the box
+        std::array<double, NB_PHASES> coldTimes; // ns per site
+        std::array<double, NB_PHASES> warmTimes; // ns per site, average over the runs
+        AllocationCounter coldAllocations;
+        AllocationCounter warmAllocations; // Per run
+        std::size_t peakHeap; // Bytes allocated at the same time during the cold run, the points excluded
+        std::size_t peakRss;
+#if FORTUNE_ENABLE_STATISTICS
+        FortuneStatistics statistics; // Of the last warm run
+#endif
+    };
+
+    // Run all the phases once and add their durations in ns to times
+    bool run(Pipeline& pipeline, const std::vector<Vector2>& points, std::size_t nbThreads,
+        std::array<double, NB_PHASES>& times)
+    {
+        const Box box{0.0, 0.0, 1.0, 1.0};
+        std::array<std::chrono::steady_clock::time_point, NB_PHASES + 1> instants;
+        instants[RESET] = std::chrono::steady_clock::now();
+        pipeline.algorithm.reset(points);
+        instants[CONSTRUCT] = std::chrono::steady_clock::now();
+        if (nbThreads > 1)
+            pipeline.algorithm.constructParallel(nbThreads);
+        else
+            pipeline.algorithm.construct();
+        instants[CLIP] = std::chrono::steady_clock::now();
+        bool isClipped = pipeline.algorithm.clip(box);
+        instants[EXPORT] = std::chrono::steady_clock::now();
+        pipeline.algorithm.getDiagram().exportCells(pipeline.cells);
+        instants[METRICS] = std::chrono::steady_clock::now();
+        pipeline.metrics.resize(points.size());
+        computeCellMetrics(pipeline.cells, pipeline.metrics, nbThreads);
+        instants[NB_PHASES] = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < NB_PHASES; ++i)
+            times[i] += std::chrono::duration<double, std::nano>(instants[i + 1] - instants[i]).count();
+        return isClipped;
+    }
+
+    bool coversBox(const CellMetrics& metrics, const Box& box)
+    {
+        double boxArea = (box.right - box.left) * (box.top - box.bottom);
+        double area = std::accumulate(metrics.areas.begin(), metrics.areas.end(), 0.0);
+        return std::abs(area - boxArea) <= 1e-9 * boxArea;
+    }
+
+    Result benchmark(Distribution distribution, std::size_t nbSites, std::size_t nbThreads, std::mt19937_64& generator)
+    {
+        Result result{};
+        result.distribution = distribution;
+        result.nbRequestedSites = nbSites;
+        std::vector<Vector2> points = generatePoints(distribution, nbSites, generator);
+        result.nbSites = points.size();
+        double nbSitesPerRun = static_cast<double>(points.size());
+        // Cold run, every buffer is allocated
+        gPeakBytes.store(gCurrentBytes.load());
+        std::size_t heapBefore = gCurrentBytes.load();
+        AllocationCounter before = AllocationCounter::now();
+        auto pipeline = std::make_unique<Pipeline>();
+        result.isClipped = run(*pipeline, points, nbThreads, result.coldTimes);
+        result.isCovered = coversBox(pipeline->metrics, Box{0.0, 0.0, 1.0, 1.0});
+        result.coldAllocations = AllocationCounter::now() - before;
+        result.peakHeap = gPeakBytes.load() - heapBefore;
+        for (double& time : result.coldTimes)
+            time /= nbSitesPerRun;
+        // Warm runs, the context is reused as the terrain does every frame
+        result.nbRuns = std::clamp<std::size_t>(SITES_PER_CASE / points.size(), 1, MAX_NB_RUNS);
+        before = AllocationCounter::now();
+        for (std::size_t i = 0; i < result.nbRuns; ++i)
+            result.isClipped = run(*pipeline, points, nbThreads, result.warmTimes) && result.isClipped;
+        AllocationCounter warmAllocations = AllocationCounter::now() - before;
+        result.warmAllocations = AllocationCounter{warmAllocations.nbAllocations / result.nbRuns,
+            warmAllocations.nbBytes / result.nbRuns};
+        for (double& time : result.warmTimes)
+            time /= nbSitesPerRun * static_cast<double>(result.nbRuns);
+        result.peakRss = getPeakRss();
+        FORTUNE_STATISTICS(result.statistics = pipeline->algorithm.getDiagram().getStatistics());
+        return result;
+    }
+
+    // Steady state
+
+    // Frames of the terrain: the sites move and bounce on the sides of the square, then the diagram is built again
+    // with the same context and indexed for the queries. Return the number of allocations after the first frame.
+    // The motion and the metrics are split over nbThreads, the workers of the library are started in the first frame.
+    std::size_t checkSteadyState(const std::vector<Vector2>& initialPoints, std::size_t nbFrames, std::size_t nbThreads,
+        std::mt19937_64& generator)
+    {
+        // About a tenth of the distance between the sites per frame
+        double speed = 0.1 / std::sqrt(static_cast<double>(initialPoints.size()));
+        std::uniform_real_distribution<double> distribution(-speed, speed);
+        std::vector<Vector2> points = initialPoints;
+        SiteMotion motion;
+        motion.resize(points.size());
+        motion.importPositions(points);
+        for (std::size_t i = 0; i < points.size(); ++i)
+        {
+            motion.vxs[i] = distribution(generator);
+            motion.vys[i] = distribution(generator);
+        }
+        const Box box{0.0, 0.0, 1.0, 1.0};
+        auto pipeline = std::make_unique<Pipeline>();
+        PointLocator locator;
+        AllocationCounter before;
+        for (std::size_t frame = 0; frame < nbFrames; ++frame)
+        {
+            if (frame == 1)
+                before = AllocationCounter::now();
+            integrateSiteMotion(motion, 1.0, box, nbThreads);
+            motion.exportPositions(points);
+            pipeline->algorithm.reset(points);
+            pipeline->algorithm.construct();
+            pipeline->algorithm.clip(box);
+            pipeline->algorithm.getDiagram().exportCells(pipeline->cells);
+            pipeline->metrics.resize(points.size());
+            computeCellMetrics(pipeline->cells, pipeline->metrics, nbThreads);
+            locator.build(pipeline->algorithm.getDiagram());
+        }
+        return nbFrames > 1 ? (AllocationCounter::now() - before).nbAllocations : 0;
+    }
+
+    // Degenerate sites
+
+    // Sites on a circle around an offset center, those at the same height differ only by the rounding
+    std::vector<Vector2> generateCocircular(std::size_t nbSites)
+    {
+        std::vector<Vector2> points(nbSites);
+        for (std::size_t i = 0; i < nbSites; ++i)
+        {
+            double angle = 2.0 * std::numbers::pi * static_cast<double>(i) / static_cast<double>(nbSites);
+            points[i] = Vector2(1.2345, 0.6789) + 300.0 * Vector2(std::cos(angle), std::sin(angle));
+        }
+        return points;
+    }
+
+    // Sites on a slanted line, their triplets are aligned up to the rounding
+    std::vector<Vector2> generateAligned(std::size_t nbSites)
+    {
+        std::vector<Vector2> points(nbSites);
+        for (std::size_t i = 0; i < nbSites; ++i)
+        {
+            double t = 0.8 * static_cast<double>(i) / static_cast<double>(nbSites - 1) - 0.4;
+            points[i] = Vector2(0.5, 0.5) + t * Vector2(std::cos(0.5), std::sin(0.5));
+        }
+        return points;
+    }
+
+    // The diagram must be clipped and its cells must cover the box
+    bool checkDegenerateCase(const char* name, const std::vector<Vector2>& points, const Box& box,
+        std::size_t nbThreads)
+    {
+        auto pipeline = std::make_unique<Pipeline>();
+        pipeline->algorithm.reset(points);
+        if (nbThreads > 1)
+            pipeline->algorithm.constructParallel(nbThreads);
+        else
+            pipeline->algorithm.construct();
+        bool isClipped = pipeline->algorithm.clip(box);
+        pipeline->algorithm.getDiagram().exportCells(pipeline->cells);
+        pipeline->metrics.resize(points.size());
+        computeCellMetrics(pipeline->cells, pipeline->metrics, nbThreads);
+        bool isCovered = coversBox(pipeline->metrics, box);
+        std::cout << std::left << std::setw(13) << name << std::right << std::setw(10) << points.size()
+            << (isClipped && isCovered ? "  ok" : "  FAILED") << '\n';
+        return isClipped && isCovered;
+    }
+
+    // Report
+
+    void printHeader()
+    {
+        std::cout << std::left << std::setw(13) << "distribution" << std::right << std::setw(10) << "sites"
+            << std::setw(7) << "runs";
+        for (const char* name : PHASE_NAMES)
+            std::cout << std::setw(11) << name;
+        std::cout << std::setw(11) << "total" << std::setw(10) << "cold" << std::setw(10) << "allocs"
+            << std::setw(8) << "warm" << std::setw(11) << "heap MB" << std::setw(10) << "RSS MB" << "  cells\n";
+    }
+
+    void printResult(const Result& result)
+    {
+        double total = 0.0;
+        std::cout << std::left << std::setw(13) << getName(result.distribution) << std::right
+            << std::setw(10) << result.nbSites << std::setw(7) << result.nbRuns << std::fixed << std::setprecision(1);
+        for (double time : result.warmTimes)
+        {
+            std::cout << std::setw(11) << time;
+            total += time;
+        }
+        double coldTotal = 0.0;
+        for (double time : result.coldTimes)
+            coldTotal += time;
+        std::cout << std::setw(11) << total << std::setw(10) << coldTotal
+            << std::setw(10) << result.coldAllocations.nbAllocations
+            << std::setw(8) << result.warmAllocations.nbAllocations
+            << std::setw(11) << static_cast<double>(result.peakHeap) / (1 << 20)
+            << std::setw(10) << static_cast<double>(result.peakRss) / (1 << 20)
+            << (result.isClipped && result.isCovered ? "  ok" : "  FAILED") << '\n' << std::defaultfloat;
+    }
+
+    void writeJson(std::ostream& os, const std::vector<Result>& results, std::size_t nbThreads, std::uint64_t seed)
+    {
+        auto writeTimes = [&os](const std::array<double, NB_PHASES>& times)
+        {
+            os << '{';
+            for (std::size_t i = 0; i < NB_PHASES; ++i)
+                os << (i > 0 ? ", " : "") << '"' << PHASE_NAMES[i] << "\": " << times[i];
+            os << '}';
+        };
+        auto writeAllocations = [&os](const AllocationCounter& allocations)
+        {
+            os << "{\"count\": " << allocations.nbAllocations << ", \"bytes\": " << allocations.nbBytes << '}';
+        };
+        os << std::setprecision(6);
+        os << "{\n  \"unit\": \"ns/site\",\n  \"threads\": " << nbThreads << ",\n  \"seed\": " << seed
+            << ",\n  \"sse2\": " << (FORTUNE_USE_SSE2 ? "true" : "false") << ",\n  \"results\": [\n";
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const Result& result = results[i];
+            os << "    {\"distribution\": \"" << getName(result.distribution) << "\", \"requested_sites\": "
+                << result.nbRequestedSites << ", \"sites\": " << result.nbSites << ", \"runs\": " << result.nbRuns
+                << ", \"clipped\": " << (result.isClipped ? "true" : "false")
+                << ", \"covered\": " << (result.isCovered ? "true" : "false") << ",\n     \"warm\": ";
+            writeTimes(result.warmTimes);
+            os << ",\n     \"cold\": ";
+            writeTimes(result.coldTimes);
+            os << ",\n     \"cold_allocations\": ";
+            writeAllocations(result.coldAllocations);
+            os << ", \"warm_allocations_per_run\": ";
+            writeAllocations(result.warmAllocations);
+            os << ",\n     \"peak_heap_bytes\": " << result.peakHeap << ", \"peak_rss_bytes\": " << result.peakRss;
+#if FORTUNE_ENABLE_STATISTICS
+            const FortuneStatistics& statistics = result.statistics;
+            os << ",\n     \"statistics\": {\"site_events\": " << statistics.nbSiteEvents
+                << ", \"circle_events\": " << statistics.nbCircleEvents
+                << ", \"created_circle_events\": " << statistics.nbCreatedCircleEvents
+                << ", \"deleted_circle_events\": " << statistics.nbDeletedCircleEvents
+                << ", \"max_beachline_size\": " << statistics.maxBeachlineSize
+                << ", \"arc_locations\": " << statistics.nbArcLocations
+                << ", \"total_arc_location_depth\": " << statistics.totalArcLocationDepth
+                << ", \"max_arc_location_depth\": " << statistics.maxArcLocationDepth
+                << ", \"created_vertices\": " << statistics.nbCreatedVertices
+                << ", \"removed_vertices\": " << statistics.nbRemovedVertices
+                << ", \"created_half_edges\": " << statistics.nbCreatedHalfEdges
+                << ", \"removed_half_edges\": " << statistics.nbRemovedHalfEdges
+                << ", \"construct_ns\": " << statistics.constructTime
+                << ", \"bound_ns\": " << statistics.boundTime
+                << ", \"intersect_ns\": " << statistics.intersectTime << '}';
+#endif
+            os << '}' << (i + 1 < results.size() ? "," : "") << '\n';
+        }
+        os << "  ]\n}\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t minNbSites = 5;
+    std::size_t maxNbSites = 10000000;
+    std::size_t nbThreads = 1;
+    std::uint64_t seed = 0;
+    std::string jsonPath;
+    std::size_t nbSteadyFrames = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << argument << '\n';
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (argument == "--min-sites")
+            minNbSites = std::strtoull(value, nullptr, 10);
+        else if (argument == "--max-sites")
+            maxNbSites = std::strtoull(value, nullptr, 10);
+        else if (argument == "--threads")
+            nbThreads = std::max<std::size_t>(std::strtoull(value, nullptr, 10), 1);
+        else if (argument == "--seed")
+            seed = std::strtoull(value, nullptr, 10);
+        else if (argument == "--json")
+            jsonPath = value;
+        else if (argument == "--steady-frames")
+            nbSteadyFrames = std::strtoull(value, nullptr, 10);
+        else
+        {
+            std::cerr << "Unknown option " << argument << '\n';
+            return 1;
+        }
+    }
+
+    const std::array<std::size_t, 8> sizes = {5, 10, 100, 1000, 10000, 100000, 1000000, 10000000};
+    std::vector<Result> results;
+    std::cout << "SSE2: " << (FORTUNE_USE_SSE2 ? "on" : "off") << ", threads: " << nbThreads
+        << ", times in ns/site, allocations per run\n";
+    printHeader();
+    for (std::size_t nbSites : sizes)
+    {
+        if (nbSites < minNbSites || nbSites > maxNbSites)
+            continue;
+        for (Distribution distribution : DISTRIBUTIONS)
+        {
+            // Each case gets its own generator so that its sites do not depend on the other cases
+            std::mt19937_64 generator(seed ^ (nbSites * 4 + static_cast<std::size_t>(distribution)));
+            results.push_back(benchmark(distribution, nbSites, nbThreads, generator));
+            printResult(results.back());
+        }
+    }
+    if (!jsonPath.empty())
+    {
+        std::ofstream file(jsonPath);
+        if (!file)
+        {
+            std::cerr << "Cannot open " << jsonPath << '\n';
+            return 1;
+        }
+        writeJson(file, results, nbThreads, seed);
+    }
+    // Degenerate sites break the sweep or the clipping before they make it slower
+    std::cout << "\ndegenerate sites\n";
+    bool isExact = true;
+    for (std::size_t nbSites : {4, 8, 12})
+    {
+        isExact = checkDegenerateCase("cocircular", generateCocircular(nbSites), Box{-500.0, -500.0, 500.0, 500.0},
+            nbThreads) && isExact;
+    }
+    for (std::size_t nbSites : {3, 4, 23, 100})
+    {
+        isExact = checkDegenerateCase("aligned", generateAligned(nbSites), Box{0.0, 0.0, 1.0, 1.0},
+            nbThreads) && isExact;
+    }
+    // An allocation in a steady frame is a regression
+    bool isSteady = true;
+    if (nbSteadyFrames > 0)
+    {
+        std::cout << "\nsteady state over " << nbSteadyFrames << " frames, allocations after the first frame\n";
+        for (const Result& result : results)
+        {
+            std::mt19937_64 generator(seed ^ (result.nbRequestedSites * 4 + static_cast<std::size_t>(result.distribution)));
+            std::vector<Vector2> points = generatePoints(result.distribution, result.nbRequestedSites, generator);
+            std::size_t nbAllocations = checkSteadyState(points, nbSteadyFrames, nbThreads, generator);
+            std::cout << std::left << std::setw(13) << getName(result.distribution) << std::right
+                << std::setw(10) << points.size() << std::setw(10) << nbAllocations
+                << (nbAllocations == 0 ? "  ok" : "  FAILED") << '\n';
+            isSteady = isSteady && nbAllocations == 0;
+        }
+    }
+    // A failed clip or a wrong diagram is a regression too
+    bool isClipped = isExact && std::all_of(results.begin(), results.end(), [](const Result& result)
+    {
+        return result.isClipped && result.isCovered;
+    });
+    return !isClipped ? 2 : !isSteady ? 3 : 0;
+}
@@ -0,0 +1,196 @@
+/* FortuneAlgorithm
+ * Copyright (C) 2018 Pierre Vigier
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+// My includes
+#include "FortuneAlgorithm.h"
+#include "SimdKernels.h"
+#include "SiteMotion.h"
+
+// Cost of the breakpoint and circle event kernels, scalar versus batched, of a whole diagram per site in double and float,
+// and of the motion of the sites
+
+namespace
+{
+    constexpr std::size_t NB_INPUTS = 1 << 12;
+
+    template<typename F>
+    double measure(std::size_t nbIterations, const F& f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < nbIterations; ++i)
+            f(i % NB_INPUTS);
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / nbIterations;
+    }
+
+    // Construction then clipping to the unit square, in ns per site
+    template<typename T>
+    std::array<double, 2> measureDiagram(const std::vector<Vector2>& points)
+    {
+        std::vector<BasicVector2<T>> convertedPoints(points.size());
+        std::transform(points.begin(), points.end(), convertedPoints.begin(),
+            [](const Vector2& point) { return BasicVector2<T>(static_cast<T>(point.x), static_cast<T>(point.y)); });
+        BasicFortuneAlgorithm<T> algorithm(std::move(convertedPoints));
+        auto start = std::chrono::steady_clock::now();
+        algorithm.construct();
+        auto middle = std::chrono::steady_clock::now();
+        algorithm.clip(BasicBox<T>{T(0), T(0), T(1), T(1)});
+        auto end = std::chrono::steady_clock::now();
+        double nbSites = static_cast<double>(points.size());
+        return {std::chrono::duration<double, std::nano>(middle - start).count() / nbSites,
+            std::chrono::duration<double, std::nano>(end - middle).count() / nbSites};
+    }
+
+    // Motion of the sites one at a time on interleaved points, with a branch per side
+    void integrateInterleaved(std::vector<Vector2>& points, std::vector<Vector2>& velocities, double dt, const Box& box)
+    {
+        for (std::size_t i = 0; i < points.size(); ++i)
+        {
+            Vector2& point = points[i];
+            Vector2& velocity = velocities[i];
+            point += velocity * dt;
+            if (point.x <= box.left || point.x >= box.right)
+            {
+                velocity = -velocity;
+                point.x = std::clamp(point.x, box.left, box.right);
+            }
+            if (point.y <= box.bottom || point.y >= box.top)
+            {
+                velocity = -velocity;
+                point.y = std::clamp(point.y, box.bottom, box.top);
+            }
+        }
+    }
+
+    constexpr std::size_t NB_MOTION_FRAMES = 100;
+
+    // In ns per site and frame
+    template<typename F>
+    double measureMotion(std::size_t nbSites, const F& f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < NB_MOTION_FRAMES; ++i)
+            f();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / (NB_MOTION_FRAMES * nbSites);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t nbIterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    std::size_t nbSites = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    std::default_random_engine generator(0);
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    auto randomPoint = [&]() { return Vector2(distribution(generator), distribution(generator)); };
+    // Triplets of sites above the sweep line at y = 0
+    std::vector<std::array<Vector2, 3>> triplets(NB_INPUTS);
+    for (auto& triplet : triplets)
+    {
+        triplet = {randomPoint(), randomPoint(), randomPoint()};
+        std::sort(triplet.begin(), triplet.end(), [](const Vector2& lhs, const Vector2& rhs) { return lhs.x < rhs.x; });
+    }
+    double sink = 0.0;
+    double breakpointsScalar = measure(nbIterations, [&](std::size_t i)
+    {
+        const auto& triplet = triplets[i];
+        sink += computeBreakpointScalar(triplet[0], triplet[1], 0.0) + computeBreakpointScalar(triplet[1], triplet[2], 0.0);
+    });
+    double breakpointsBatched = measure(nbIterations, [&](std::size_t i)
+    {
+        const auto& triplet = triplets[i];
+        std::array<double, 2> breakpoints = computeBreakpoints(triplet[0], triplet[1], triplet[2], 0.0);
+        sink += breakpoints[0] + breakpoints[1];
+    });
+    double circleEventsScalar = measure(nbIterations, [&](std::size_t i)
+    {
+        const auto& left = triplets[i];
+        const auto& right = triplets[(i + 1) % NB_INPUTS];
+        Vector2 center;
+        double y;
+        sink += computeCircleEventScalar(left[0], left[1], left[2], 1.0, center, y) ? y : 0.0;
+        sink += computeCircleEventScalar(right[0], right[1], right[2], 1.0, center, y) ? y : 0.0;
+    });
+    double circleEventsBatched = measure(nbIterations, [&](std::size_t i)
+    {
+        const auto& left = triplets[i];
+        const auto& right = triplets[(i + 1) % NB_INPUTS];
+        std::array<Vector2, 2> centers;
+        std::array<double, 2> ys;
+        unsigned int exists = computeCircleEvents({{{&left[0], &left[1], &left[2]}, {&right[0], &right[1], &right[2]}}},
+            1.0, centers, ys);
+        sink += ((exists & 1u) ? ys[0] : 0.0) + ((exists & 2u) ? ys[1] : 0.0);
+    });
+    // Whole construction, each site causes one site event and about one circle event
+    std::vector<Vector2> points(nbSites);
+    for (auto& point : points)
+        point = randomPoint();
+    std::array<double, 2> diagramDouble = measureDiagram<double>(points);
+    std::array<double, 2> diagramFloat = measureDiagram<float>(points);
+    // Motion, fast enough that the sites reach the sides during the frames
+    std::uniform_real_distribution<double> velocityDistribution(-1.0, 1.0);
+    std::vector<Vector2> velocities(nbSites);
+    for (auto& velocity : velocities)
+        velocity = Vector2(velocityDistribution(generator), velocityDistribution(generator));
+    SiteMotion motion;
+    motion.resize(nbSites);
+    motion.importPositions(points);
+    for (std::size_t i = 0; i < nbSites; ++i)
+    {
+        motion.vxs[i] = velocities[i].x;
+        motion.vys[i] = velocities[i].y;
+    }
+    constexpr double DT = 1.0 / 60.0;
+    const Box box{0.0, 0.0, 1.0, 1.0};
+    std::size_t nbThreads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    double motionInterleaved = measureMotion(nbSites, [&]() { integrateInterleaved(points, velocities, DT, box); });
+    double motionSeparate = measureMotion(nbSites, [&]() { integrateSiteMotion(motion, DT, box); });
+    double motionThreads = measureMotion(nbSites, [&]() { integrateSiteMotion(motion, DT, box, nbThreads); });
+    // Same state, the separate arrays were moved twice as many frames
+    for (std::size_t i = 0; i < NB_MOTION_FRAMES; ++i)
+        integrateInterleaved(points, velocities, DT, box);
+    std::size_t nbMismatches = 0;
+    for (std::size_t i = 0; i < nbSites; ++i)
+    {
+        if (points[i].x != motion.xs[i] || points[i].y != motion.ys[i] || velocities[i].x != motion.vxs[i] ||
+            velocities[i].y != motion.vys[i])
+            ++nbMismatches;
+    }
+
+    std::cout << "SSE2: " << (FORTUNE_USE_SSE2 ? "on" : "off") << '\n';
+    std::cout << "breakpoint pair, scalar:    " << breakpointsScalar << " ns\n";
+    std::cout << "breakpoint pair, batched:   " << breakpointsBatched << " ns\n";
+    std::cout << "circle event pair, scalar:  " << circleEventsScalar << " ns\n";
+    std::cout << "circle event pair, batched: " << circleEventsBatched << " ns\n";
+    std::cout << "double, construct: " << diagramDouble[0] << " ns/site, clip: " << diagramDouble[1] << " ns/site (" << nbSites << " sites)\n";
+    std::cout << "float, construct:  " << diagramFloat[0] << " ns/site, clip: " << diagramFloat[1] << " ns/site (" << nbSites << " sites)\n";
+    std::cout << "motion, interleaved:        " << motionInterleaved << " ns/site\n";
+    std::cout << "motion, separate arrays:    " << motionSeparate << " ns/site\n";
+    std::cout << "motion, separate, threads:  " << motionThreads << " ns/site (" << nbThreads << " threads, " << nbMismatches << " sites differ)\n";
+    // Print the sum so that the compiler cannot skip the computations
+    std::cout << "checksum: " << sink << '\n';
+    return 0;
+}